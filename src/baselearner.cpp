@@ -68,18 +68,56 @@ std::string Baselearner::getDataIdentifier () const
   return data_ptr->getDataIdentifier();
 }
 
+// By default a base-learner needs the response for training. The optimizer 
+// just calls this function for factories which provide X^T r (it may be 
+// called from the training thread, hence no R API is used):
+double Baselearner::trainCrossprod (const arma::vec& crossprod, const ResponseSummary& response_summary)
+{
+  throw std::runtime_error("Base-learner " + blearner_type + " can't be trained from the cross product with the response.");
+  return 0;
+}
+
+double Baselearner::trainSubsample (const arma::vec& crossprod, const arma::mat& gram, 
+  const ResponseSummary& response_summary)
+{
+  throw std::runtime_error("Base-learner " + blearner_type + " can't be trained on a subsample of the rows.");
+  return 0;
+}
+
 // Get the parameter obtained by training:
 arma::mat Baselearner::getParameter () const
 {
   return parameter;
 }
 
+void Baselearner::setParameter (const arma::mat& parameter0)
+{
+  parameter = parameter0;
+}
+
+bool Baselearner::isLinearInParameter () const
+{
+  return false;
+}
+
 // Predict function. This one calls the virtual function with the data pointer:
 // arma::mat Baselearner::predict ()
 // {
 //   return predict(*data_ptr);
 // }
 
+// Transform newdata into a new data target. By default the target holds the
+// dense matrix of 'instantiateData'. Note that the caller owns the returned
+// object:
+data::Data* Baselearner::instantiateDataTarget (data::Data* newdata)
+{
+  data::Data* newdata_target = new data::InMemoryData();
+  newdata_target->setDataIdentifier(newdata->getDataIdentifier());
+  newdata_target->setData(instantiateData(newdata->getSourceData()));
+  
+  return newdata_target;
+}
+
 // Function to set the identifier (should be unique over all baselearner):
 void Baselearner::setIdentifier (const std::string& id0)
 {
@@ -162,6 +200,28 @@ arma::mat BaselearnerPolynomial::instantiateData (const arma::mat& newdata)
 // Train the learner:
 void BaselearnerPolynomial::train (const arma::vec& response)
 {
+  // Just the sums of the response per bin are required for binned features:
+  if (data_ptr->hasBinnedData()) {
+    arma::vec response_sums = data_ptr->sumPerBin(response);
+    
+    double y_mean = 0;
+    if (intercept) {
+      y_mean = arma::accu(response_sums) / arma::accu(data_ptr->bin_counts);
+    }
+    double slope = arma::accu((data_ptr->bin_data_mat - data_ptr->XtX_inv(0,0)) % (response_sums - y_mean * data_ptr->bin_counts)) / data_ptr->XtX_inv(0,1);
+    
+    if (intercept) {
+      arma::mat out(2,1);
+      
+      out(0,0) = y_mean - slope * data_ptr->XtX_inv(0,0);
+      out(1,0) = slope;
+      
+      parameter = out;
+    } else {
+      parameter = slope;
+    }
+    return;
+  }
   if (data_ptr->getData().n_cols == 1) {
     double y_mean = 0;
     if (intercept) {
@@ -187,22 +247,101 @@ void BaselearnerPolynomial::train (const arma::vec& response)
   }
 }
 
-// Predict the learner:
-arma::mat BaselearnerPolynomial::predict ()
+// The cross product is the one of the (powered) feature with the response. 
+// For one feature, the slope is computed with the mean and the sum of squares
+// which are stored in the target by the factory, and the sum of squared 
+// errors is the one of the simple linear regression:
+double BaselearnerPolynomial::trainCrossprod (const arma::vec& crossprod, const ResponseSummary& response_summary)
 {
-  if (data_ptr->getData().n_cols == 1) {
+  if (data_ptr->XtX_inv.n_rows == 1 && data_ptr->XtX_inv.n_cols == 2) {
+    double x_mean = data_ptr->XtX_inv(0,0);
+    double x_ssq  = data_ptr->XtX_inv(0,1);
+    
+    double y_mean = 0;
+    if (intercept) {
+      y_mean = response_summary.sum / response_summary.n_obs;
+    }
+    double slope = (crossprod[0] - response_summary.n_obs * x_mean * y_mean) / x_ssq;
+    
     if (intercept) {
-      return parameter(0) + data_ptr->getData() * parameter(1);
+      arma::mat out(2,1);
+      
+      out(0,0) = y_mean - slope * x_mean;
+      out(1,0) = slope;
+      
+      parameter = out;
     } else {
-      return data_ptr->getData() * parameter;
+      parameter = slope;
     }
-  } else {
-    return data_ptr->getData() * parameter;
+    return response_summary.ssq - response_summary.n_obs * y_mean * y_mean - slope * slope * x_ssq;
+  }
+  parameter = data_ptr->XtX_inv * crossprod;
+  
+  return response_summary.ssq - arma::dot(parameter, crossprod);
+}
+
+// On a subsample, the cross products include the intercept column (if used)
+// and the parameter is the least squares solution:
+double BaselearnerPolynomial::trainSubsample (const arma::vec& crossprod, const arma::mat& gram, 
+  const ResponseSummary& response_summary)
+{
+  arma::vec beta;
+  if (! arma::solve(beta, gram, crossprod)) {
+    beta = arma::pinv(gram) * crossprod;
   }
+  parameter = beta;
+  
+  return response_summary.ssq - arma::dot(beta, crossprod);
+}
+
+// Predict the learner:
+arma::mat BaselearnerPolynomial::predict ()
+{
+  return predictDataTarget(data_ptr);
 }
 arma::mat BaselearnerPolynomial::predict (data::Data* newdata)
 {
-  return instantiateData(newdata->getData()) * parameter;
+  return instantiateData(newdata->getSourceData()) * parameter;
+}
+
+bool BaselearnerPolynomial::isLinearInParameter () const
+{
+  return true;
+}
+
+// In the case of one feature the target just contains x^degree without 
+// intercept column (see the factory):
+data::Data* BaselearnerPolynomial::instantiateDataTarget (data::Data* newdata)
+{
+  data::Data* newdata_target = new data::InMemoryData();
+  newdata_target->setDataIdentifier(newdata->getDataIdentifier());
+  
+  if (newdata->getSourceData().n_cols == 1) {
+    newdata_target->setData(arma::pow(newdata->getSourceData(), degree));
+  } else {
+    newdata_target->setData(instantiateData(newdata->getSourceData()));
+  }
+  return newdata_target;
+}
+
+arma::mat BaselearnerPolynomial::predictDataTarget (data::Data* data_target)
+{
+  if (data_target->hasBinnedData()) {
+    if (intercept) {
+      return data_target->expandBins(parameter(0) + data_target->bin_data_mat * parameter(1));
+    } else {
+      return data_target->multiplyBins(parameter);
+    }
+  }
+  if (data_target->getData().n_cols == 1) {
+    if (intercept) {
+      return parameter(0) + data_target->getData() * parameter(1);
+    } else {
+      return data_target->getData() * parameter;
+    }
+  } else {
+    return data_target->getData() * parameter;
+  }
 }
 
 // Destructor:
@@ -246,16 +385,24 @@ BaselearnerPolynomial::~BaselearnerPolynomial () {}
  *   polynomial form.
  * \param differences `unsigned int` Number of differences used for the 
  *   penalty matrix.
+ * \param use_sparse_matrices `bool` Flag if sparse matrices are used
+ * \param XtX_inv_ptr `arma::mat*` Inverse of the penalized cross product
+ *   which is owned by the factory
+ * \param penalty_mat_ptr `arma::mat*` Penalty matrix which is owned by the 
+ *   factory
  */
 
 BaselearnerPSpline::BaselearnerPSpline (data::Data* data, const std::string& identifier,
   const unsigned int& degree, const unsigned int& n_knots, const double& penalty, 
-  const unsigned int& differences, const bool& use_sparse_matrices)
+  const unsigned int& differences, const bool& use_sparse_matrices, const arma::mat* XtX_inv_ptr,
+  const arma::mat* penalty_mat_ptr)
   : degree ( degree ),
     n_knots ( n_knots ),
     penalty ( penalty ),
     differences ( differences ),
-    use_sparse_matrices ( use_sparse_matrices )
+    use_sparse_matrices ( use_sparse_matrices ),
+    XtX_inv_ptr ( XtX_inv_ptr ),
+    penalty_mat_ptr ( penalty_mat_ptr )
 { 
   // Called from parent class 'Baselearner':
   Baselearner::setData(data);
@@ -295,20 +442,151 @@ arma::mat BaselearnerPSpline::instantiateData (const arma::mat& newdata)
   return createSplineBasis (newdata, degree, data_ptr->knots);
 }
 
+/**
+ * \brief Use multiple penalties and choose one in every training
+ * 
+ * \param penalty_candidates0 `PenaltyCandidates*` penalties and 
+ *   Demmler-Reinsch decomposition which are owned by the factory
+ */
+void BaselearnerPSpline::setPenaltyCandidates (const PenaltyCandidates* penalty_candidates0)
+{
+  penalty_candidates = penalty_candidates0;
+}
+
+arma::vec BaselearnerPSpline::crossprodResponse (const arma::vec& response) const
+{
+  if (data_ptr->isChunked()) {
+    return static_cast<data::ChunkedData*>(data_ptr)->crossprodChunks(response);
+  } else if (data_ptr->hasBinnedData()) {
+    return data_ptr->crossprodBins(response);
+  } else if (data_ptr->hasSinglePrecisionData()) {
+    return data_ptr->crossprodSinglePrecision(response);
+  } else if (use_sparse_matrices) {
+    return data_ptr->sparse_data_mat * response;
+  } else {
+    return data_ptr->data_mat.t() * response;
+  }
+}
+
 /**
  * \brief Training of a baselearner
  * 
  * This function sets the `parameter` member of the parent class `Baselearner`.
  * 
+ * With multiple penalties, \f$X^T r\f$ is computed once and every penalty is
+ * scored in \f$O(p)\f$ with the Demmler-Reinsch decomposition. With 
+ * \f$z = A^T X^T r\f$ and the shrinkage \f$h_i = 1 / (1 + \lambda s_i)\f$
+ * the sum of squared errors is
+ * \f$\|r\|^2 - \sum_i z_i^2 (2 h_i - h_i^2)\f$ and the degrees of 
+ * freedom are \f$\sum_i h_i\f$. Since the sum of squared errors always 
+ * prefers the smallest penalty, the penalty with the smallest generalized 
+ * cross validation criterion \f$n \mathrm{SSE} / (n - \mathrm{df})^2\f$ is
+ * chosen.
+ * 
  * \param response `arma::vec` Response variable of the training.
  */
 void BaselearnerPSpline::train (const arma::vec& response)
 {
-  if (use_sparse_matrices) {
-    parameter = data_ptr->XtX_inv * (data_ptr->sparse_data_mat * response);
+  trainCrossprod(crossprodResponse(response), ResponseSummary(response));
+}
+
+/**
+ * \brief Training from the cross product with the response
+ * 
+ * With \f$\beta = (X^T X + \lambda K)^{-1} X^T r\f$ the sum of squared 
+ * errors is \f$r^T r - 2 \beta^T X^T r + \beta^T X^T X \beta\f$, hence 
+ * neither the prediction nor the response are required.
+ * 
+ * \param crossprod `arma::vec` Cross product \f$X^T r\f$.
+ * \param response_summary `ResponseSummary` Number of observations, sum, 
+ *   and sum of squares of the response.
+ * 
+ * \returns `double` Sum of squared errors of the fit.
+ */
+double BaselearnerPSpline::trainCrossprod (const arma::vec& crossprod, const ResponseSummary& response_summary)
+{
+  if (penalty_candidates == NULL) {
+    parameter = *XtX_inv_ptr * crossprod;
   } else {
-    parameter = data_ptr->XtX_inv * data_ptr->data_mat.t() * response;
+    arma::vec z = penalty_candidates->dr_basis.t() * crossprod;
+    arma::vec z_squared = arma::pow(z, 2);
+    
+    double n_obs = response_summary.n_obs;
+    double gcv_best = std::numeric_limits<double>::infinity();
+    arma::vec shrinkage_best;
+    
+    for (unsigned int k = 0; k < penalty_candidates->penalties.n_elem; k++) {
+      double penalty_k = penalty_candidates->penalties[k];
+      arma::vec shrinkage = 1 / (1 + penalty_k * penalty_candidates->dr_eigenvalues);
+      
+      double sse = response_summary.ssq - arma::accu(z_squared % (2 * shrinkage - arma::pow(shrinkage, 2)));
+      double df = arma::accu(shrinkage);
+      double gcv = n_obs * sse / std::pow(n_obs - df, 2);
+      
+      if (gcv < gcv_best) {
+        gcv_best       = gcv;
+        shrinkage_best = shrinkage;
+      }
+    }
+    parameter = penalty_candidates->dr_basis * (z % shrinkage_best);
+  }
+  arma::vec beta = parameter;
+  
+  return response_summary.ssq - 2 * arma::dot(beta, crossprod) + arma::as_scalar(beta.t() * data_ptr->XtX * beta);
+}
+
+/**
+ * \brief Training on a subsample of the rows
+ * 
+ * The inverse and the Demmler-Reinsch decomposition of the factory belong to
+ * the cross product of all rows. Hence, the penalized system of the 
+ * subsample is solved directly, which is cheap for the small number of basis
+ * functions. With multiple penalties, the generalized cross validation 
+ * criterion is computed for every penalty.
+ * 
+ * \param crossprod `arma::vec` Cross product \f$X_S^T r_S\f$ of the subsample.
+ * \param gram `arma::mat` Cross product \f$X_S^T X_S\f$ of the subsample.
+ * \param response_summary `ResponseSummary` Summary of the subsampled response.
+ * 
+ * \returns `double` Sum of squared errors on the subsample.
+ */
+double BaselearnerPSpline::trainSubsample (const arma::vec& crossprod, const arma::mat& gram, 
+  const ResponseSummary& response_summary)
+{
+  const arma::mat& penalty_mat = *penalty_mat_ptr;
+  
+  arma::vec penalties (1);
+  penalties[0] = penalty;
+  if (penalty_candidates != NULL) {
+    penalties = penalty_candidates->penalties;
+  }
+  double n_obs = response_summary.n_obs;
+  double gcv_best = std::numeric_limits<double>::infinity();
+  double sse_best = 0;
+  arma::vec beta_best;
+  
+  for (unsigned int k = 0; k < penalties.n_elem; k++) {
+    arma::mat system_mat = gram + penalties[k] * penalty_mat;
+    arma::vec beta;
+    if (! arma::solve(beta, system_mat, crossprod)) {
+      beta = arma::pinv(system_mat) * crossprod;
+    }
+    double sse = response_summary.ssq - 2 * arma::dot(beta, crossprod) + arma::as_scalar(beta.t() * gram * beta);
+    
+    double gcv = sse;
+    if (penalties.n_elem > 1) {
+      double df = arma::trace(arma::solve(system_mat, gram));
+      gcv = n_obs * sse / std::pow(n_obs - df, 2);
+    }
+    if (gcv < gcv_best) {
+      gcv_best  = gcv;
+      sse_best  = sse;
+      beta_best = beta;
+    }
   }
+  parameter = beta_best;
+  
+  return sse_best;
 }
 
 /**
@@ -318,16 +596,7 @@ void BaselearnerPSpline::train (const arma::vec& response)
  */
 arma::mat BaselearnerPSpline::predict ()
 {
-  // arma::mat out;
-  if (use_sparse_matrices) {
-    // Trick to speed up things. Try to avoid transposing the sparse matrix. The
-    // original one (data_ptr->sparse_data_mat * parameter) is about 4 or 5 times
-    // slower than that one:
-    return (parameter.t() * data_ptr->sparse_data_mat).t();
-  } else {
-    return data_ptr->data_mat * parameter;
-  }
-  // return out;
+  return predictDataTarget(data_ptr);
 }
 
 /**
@@ -339,7 +608,65 @@ arma::mat BaselearnerPSpline::predict ()
  */
 arma::mat BaselearnerPSpline::predict (data::Data* newdata)
 {
-  return instantiateData(newdata->getData()) * parameter;
+  return instantiateData(newdata->getSourceData()) * parameter;
+}
+
+bool BaselearnerPSpline::isLinearInParameter () const
+{
+  return true;
+}
+
+/**
+ * \brief Transform newdata into the layout of the training data
+ * 
+ * If sparse matrices are used, the target stores the transposed sparse 
+ * basis exactly as the factory does for the training data. Hence, the basis
+ * of fixed new data (e.g. the OOB data) is computed just once.
+ * 
+ * \param newdata `data::Data*` new source data object
+ * 
+ * \returns `data::Data*` new data target (owned by the caller)
+ */
+data::Data* BaselearnerPSpline::instantiateDataTarget (data::Data* newdata)
+{
+  data::Data* newdata_target = new data::InMemoryData();
+  newdata_target->setDataIdentifier(newdata->getDataIdentifier());
+  
+  if (use_sparse_matrices) {
+    newdata_target->sparse_data_mat = createSparseSplineBasis(newdata->getSourceData(), degree, data_ptr->knots).t();
+  } else {
+    newdata_target->setData(instantiateData(newdata->getSourceData()));
+  }
+  return newdata_target;
+}
+
+/**
+ * \brief Predict on a transformed data target
+ * 
+ * \param data_target `data::Data*` data target with the same layout as the
+ *   training data
+ * 
+ * \returns `arma::mat` of predicted values
+ */
+arma::mat BaselearnerPSpline::predictDataTarget (data::Data* data_target)
+{
+  if (data_target->isChunked()) {
+    return static_cast<data::ChunkedData*>(data_target)->multiplyChunks(parameter);
+  }
+  if (data_target->hasBinnedData()) {
+    return data_target->multiplyBins(parameter);
+  }
+  if (data_target->hasSinglePrecisionData()) {
+    return data_target->multiplySinglePrecision(parameter);
+  }
+  if (use_sparse_matrices) {
+    // Trick to speed up things. Try to avoid transposing the sparse matrix. The
+    // original one (data_ptr->sparse_data_mat * parameter) is about 4 or 5 times
+    // slower than that one:
+    return (parameter.t() * data_target->sparse_data_mat).t();
+  } else {
+    return data_target->data_mat * parameter;
+  }
 }
 
 
@@ -394,12 +721,16 @@ void BaselearnerCustom::train (const arma::vec& response)
 // Predict by using the R function 'predictFun':
 arma::mat BaselearnerCustom::predict ()
 {
-  Rcpp::NumericMatrix out = predictFun(model, data_ptr->getData());
-  return Rcpp::as<arma::mat>(out);
+  return predictDataTarget(data_ptr);
 }
 arma::mat BaselearnerCustom::predict (data::Data* newdata)
 {
-  Rcpp::NumericMatrix out = predictFun(model, instantiateData(newdata->getData()));
+  Rcpp::NumericMatrix out = predictFun(model, instantiateData(newdata->getSourceData()));
+  return Rcpp::as<arma::mat>(out);
+}
+arma::mat BaselearnerCustom::predictDataTarget (data::Data* data_target)
+{
+  Rcpp::NumericMatrix out = predictFun(model, data_target->getData());
   return Rcpp::as<arma::mat>(out);
 }
 
@@ -460,13 +791,17 @@ void BaselearnerCustomCpp::train (const arma::vec& response)
 
 arma::mat BaselearnerCustomCpp::predict ()
 {
-  return predictFun (data_ptr->getData(), parameter);
+  return predictDataTarget(data_ptr);
 }
 arma::mat BaselearnerCustomCpp::predict (data::Data* newdata)
 {
-  arma::mat temp_mat = instantiateData(newdata->getData());
+  arma::mat temp_mat = instantiateData(newdata->getSourceData());
   return predictFun (temp_mat, parameter);
 }
+arma::mat BaselearnerCustomCpp::predictDataTarget (data::Data* data_target)
+{
+  return predictFun (data_target->getData(), parameter);
+}
 
 // Destructor:
 BaselearnerCustomCpp::~BaselearnerCustomCpp () {}
@@ -38,12 +38,36 @@
 
 #include <RcppArmadillo.h>
 #include <string>
+#include <limits>
 
 #include "data.h"
 #include "splines.h"
 
 namespace blearner {
 
+// Summary of the response which is computed once per iteration and shared by
+// all base-learners which are trained from X^T r (see `trainCrossprod()`):
+struct ResponseSummary
+{
+  double n_obs;
+  double sum;
+  double ssq;
+  
+  ResponseSummary (const arma::vec& response)
+    : n_obs ( response.n_elem ),
+      sum ( arma::accu(response) ),
+      ssq ( arma::dot(response, response) )
+  { }
+  
+  // Weighted least squares with the response `weighted_response / weights` 
+  // (Newton steps), the sums are weighted:
+  ResponseSummary (const arma::vec& weighted_response, const arma::vec& weights)
+    : n_obs ( weighted_response.n_elem ),
+      sum ( arma::accu(weighted_response) ),
+      ssq ( arma::accu(arma::square(weighted_response) / weights) )
+  { }
+};
+
 // -------------------------------------------------------------------------- //
 // Abstract 'Baselearner' class:
 // -------------------------------------------------------------------------- //
@@ -53,8 +77,27 @@ class Baselearner
 public:
 
   virtual void train (const arma::vec&) = 0;
+  
+  // Train from X^T r which is computed by the optimizer for all base-learners
+  // in one sweep (see `BaselearnerFactory::addCrossprodBlock()`). Returns the
+  // sum of squared errors of the fit which is computed in closed form:
+  virtual double trainCrossprod (const arma::vec&, const ResponseSummary&);
+  
+  // Train on a subsample of the rows from X^T r and X^T X of the subsample 
+  // (see `Compboost::setRowSubsampling()`). With weights (Newton steps), 
+  // X^T W X is given instead of X^T X. Returns the (weighted) sum of squared
+  // errors on the subsample:
+  virtual double trainSubsample (const arma::vec&, const arma::mat&, const ResponseSummary&);
+  
   arma::mat getParameter () const;
   
+  // Set the parameter without training, used to restore a saved model:
+  void setParameter (const arma::mat&);
+  
+  // Tag if the prediction is linear in the parameter. Then, scaling the
+  // parameter scales the prediction (used for the line search):
+  virtual bool isLinearInParameter () const;
+  
   virtual arma::mat predict () = 0;
   virtual arma::mat predict (data::Data*) = 0;
   
@@ -63,6 +106,13 @@ public:
   // arma mat as parameter is used for newdata:
   virtual arma::mat instantiateData (const arma::mat&) = 0;
   
+  // Transform newdata once into a data target with the same layout as the
+  // training data (e.g. the transposed sparse basis for splines). Predicting
+  // on that target then doesn't require another transformation, which is 
+  // used for fixed evaluation data such as the OOB data:
+  virtual data::Data* instantiateDataTarget (data::Data*);
+  virtual arma::mat predictDataTarget (data::Data*) = 0;
+  
   // Clone function (in some places needed e.g. "optimizer.cpp") and a copy
   // function which is called by clone to avoid copy and pasting of the 
   // protected members:
@@ -132,8 +182,14 @@ public:
   arma::mat instantiateData (const arma::mat&);
   
   void train (const arma::vec&);
+  double trainCrossprod (const arma::vec&, const ResponseSummary&);
+  double trainSubsample (const arma::vec&, const arma::mat&, const ResponseSummary&);
+  bool isLinearInParameter () const;
   arma::mat predict ();
   arma::mat predict (data::Data*);
+  
+  data::Data* instantiateDataTarget (data::Data*);
+  arma::mat predictDataTarget (data::Data*);
 
   ~BaselearnerPolynomial ();
   
@@ -142,6 +198,16 @@ public:
 // BaselearnerPSpline:
 // -----------------------
 
+// Demmler-Reinsch representation of a spline factory with multiple penalties
+// (see `demmlerReinsch()`), owned by the factory and shared by its 
+// base-learners:
+struct PenaltyCandidates
+{
+  arma::vec penalties;
+  arma::mat dr_basis;
+  arma::vec dr_eigenvalues;
+};
+
 /**
  * \class BaselearnerPSpline
  * 
@@ -179,26 +245,54 @@ private:
   /// Flag if sparse matrices should be used:
   const bool use_sparse_matrices;
 
+  /// Inverse of the penalized cross product owned by the factory
+  const arma::mat* XtX_inv_ptr;
+
+  /// Penalty matrix owned by the factory
+  const arma::mat* penalty_mat_ptr;
+
+  /// Penalties to choose from in every training (NULL for one penalty)
+  const PenaltyCandidates* penalty_candidates = NULL;
+
+  /// Compute X^T r for all layouts of the target
+  arma::vec crossprodResponse (const arma::vec&) const;
+
 public:
   /// Default constructor of `BaselearnerPSpline` class
   BaselearnerPSpline (data::Data*, const std::string&, const unsigned int&,
-    const unsigned int&, const double&, const unsigned int&, const bool&);
+    const unsigned int&, const double&, const unsigned int&, const bool&, 
+    const arma::mat*, const arma::mat*);
   
   /// Clean copy of baselearner
   Baselearner* clone ();
   
+  /// Choose the penalty of every training from multiple penalties
+  void setPenaltyCandidates (const PenaltyCandidates*);
+  
   /// Instatiate data matrix (design matrix)
   arma::mat instantiateData (const arma::mat&);
   
   /// Trianing of a baselearner
   void train (const arma::vec&);
   
+  /// Training from X^T r, returns the sum of squared errors
+  double trainCrossprod (const arma::vec&, const ResponseSummary&);
+  
+  /// Training on a subsample of the rows, the penalized system is solved directly
+  double trainSubsample (const arma::vec&, const arma::mat&, const ResponseSummary&);
+  bool isLinearInParameter () const;
+  
   /// Predict on training data
   arma::mat predict ();
   
   /// Predict on newdata
   arma::mat predict (data::Data*);
   
+  /// Transform newdata into the (sparse) layout of the training data
+  data::Data* instantiateDataTarget (data::Data*);
+  
+  /// Predict on a transformed data target
+  arma::mat predictDataTarget (data::Data*);
   
   /// Destructor
   ~BaselearnerPSpline ();
@@ -240,6 +334,7 @@ public:
   void train (const arma::vec&);
   arma::mat predict ();
   arma::mat predict (data::Data*);
+  arma::mat predictDataTarget (data::Data*);
   
   ~BaselearnerCustom ();
   
@@ -285,6 +380,7 @@ public:
   void train (const arma::vec&);
   arma::mat predict ();
   arma::mat predict (data::Data*);
+  arma::mat predictDataTarget (data::Data*);
   
   ~BaselearnerCustomCpp ();
   
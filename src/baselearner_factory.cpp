@@ -66,11 +66,144 @@ void BaselearnerFactory::initializeDataObjects (data::Data* data_source0,
   data_target->setDataIdentifier(data_source->getDataIdentifier());
   
   // Get the data of the source, transform it and write it into the target:
-  data_target->setData(instantiateData(data_source->getData()));
+  data_target->setData(instantiateData(data_source->getSourceData()));
+}
+
+// By default a factory can't be represented by a piecewise polynomial:
+bool BaselearnerFactory::hasPiecewisePolynomial () const
+{
+  return false;
+}
+
+pwpolynomial::PiecewisePolynomial BaselearnerFactory::toPiecewisePolynomial (const arma::mat& parameter) const
+{
+  throw std::runtime_error("Base-learner " + getDataIdentifier() + "_" + blearner_type + " can't be represented as piecewise polynomial.");
+  return pwpolynomial::PiecewisePolynomial();
+}
+
+// By default a factory is implemented in C++:
+bool BaselearnerFactory::usesRFunctions () const
+{
+  return false;
+}
+
+// By default the base-learner is trained on the response:
+unsigned int BaselearnerFactory::getCrossprodSize () const
+{
+  return 0;
+}
+
+void BaselearnerFactory::addCrossprodBlock (const arma::vec& response, const unsigned int& first,
+  const unsigned int& last, arma::vec& crossprod) const
+{
+  throw std::runtime_error("Base-learner " + blearner_type + " doesn't provide the cross product with the response.");
+}
+
+unsigned int BaselearnerFactory::getSubsampleSize () const
+{
+  return 0;
+}
+
+void BaselearnerFactory::addSubsampleBlock (const arma::vec& response, const arma::uvec& row_idx, 
+  const arma::vec& weights, const unsigned int& first, const unsigned int& last, arma::vec& crossprod, 
+  arma::mat& gram) const
+{
+  throw std::runtime_error("Base-learner " + blearner_type + " can't be trained on a subsample of the rows.");
+}
+
+arma::vec BaselearnerFactory::predictData (const arma::mat& parameter) const
+{
+  return getData() * parameter;
+}
+
+DesignBlock BaselearnerFactory::getDesignBlock (const unsigned int& first, const unsigned int& last) const
+{
+  throw std::runtime_error("Base-learner " + blearner_type + " doesn't provide the design matrix.");
+}
+
+bool BaselearnerFactory::isLinearSmoother () const
+{
+  return false;
+}
+
+// By default the setup is finished in the constructor:
+bool BaselearnerFactory::hasPendingSetup () const
+{
+  return false;
+}
+
+void BaselearnerFactory::finishSetup () {}
+
+// By default a factory can't be restored (e.g. custom factories with R functions):
+void BaselearnerFactory::saveFactory (std::ostream& out) const
+{
+  Rcpp::stop("Base-learner " + getDataIdentifier() + "_" + blearner_type + " can't be saved, just polynomial and spline base-learner are supported.");
 }
 
 BaselearnerFactory::~BaselearnerFactory () {}
 
+// -------------------------------------------------------------------------- //
+// DesignBlock:
+// -------------------------------------------------------------------------- //
+
+arma::vec DesignBlock::crossprod (const arma::vec& response) const
+{
+  if (is_sparse) {
+    return design_t * response;
+  }
+  return design.t() * response;
+}
+
+arma::mat DesignBlock::gram () const
+{
+  if (is_sparse) {
+    return arma::mat(design_t * design_t.t());
+  }
+  return design.t() * design;
+}
+
+arma::mat DesignBlock::crossGram (const DesignBlock& other) const
+{
+  if (is_sparse && other.is_sparse) {
+    return arma::mat(design_t * other.design_t.t());
+  }
+  if (is_sparse) {
+    return design_t * other.design;
+  }
+  if (other.is_sparse) {
+    return (other.design_t * design).t();
+  }
+  return design.t() * other.design;
+}
+
+// -------------------------------------------------------------------------- //
+// Helper functions:
+// -------------------------------------------------------------------------- //
+
+// The rows of a column major matrix aren't contiguous, hence `rows().t()`
+// would copy the block. The columns of the block are contiguous views:
+static void addDenseCrossprodBlock (const arma::mat& data_mat, const arma::vec& response, 
+  const unsigned int& first, const unsigned int& last, arma::vec& crossprod)
+{
+  for (unsigned int j = 0; j < data_mat.n_cols; j++) {
+    crossprod[j] += arma::dot(data_mat.col(j).subvec(first, last), response.subvec(first, last));
+  }
+}
+
+// The sparse basis is stored transposed, hence the rows of the block are the
+// columns [first, last] which are read from the compressed storage instead of
+// creating the sub matrix:
+static void addSparseCrossprodBlock (const arma::sp_mat& basis_t, const arma::vec& response, 
+  const unsigned int& first, const unsigned int& last, arma::vec& crossprod)
+{
+  basis_t.sync();
+  for (unsigned int i = first; i <= last; i++) {
+    for (unsigned int j = basis_t.col_ptrs[i]; j < basis_t.col_ptrs[i + 1]; j++) {
+      crossprod[basis_t.row_indices[j]] += basis_t.values[j] * response[i];
+    }
+  }
+}
+
 // -------------------------------------------------------------------------- //
 // BaselearnerFactory implementations:
 // -------------------------------------------------------------------------- //
@@ -92,10 +225,39 @@ BaselearnerPolynomialFactory::BaselearnerPolynomialFactory (const std::string& b
   // Make sure that the data identifier is setted correctly:
   data_target->setDataIdentifier(data_source->getDataIdentifier());
   
+  // Skip the preparation if the target was restored by `loadData()` for the
+  // same configuration and raw data:
+  std::stringstream tag;
+  tag << "polynomial;degree=" << degree << ";intercept=" << intercept << ";bins=" 
+      << data_target->getNumberOfBins() << ";" << serialize::fingerprint(data_source->getSourceData());
+  data_target->checkPreparation(tag.str());
+  data_target->markAsUsedByFactory();
+  
+  if (data_target->getPreparationTag() == tag.str()) {
+    return;
+  }
+  data_target->setPreparationTag(tag.str());
+  
+  // Binned feature, the mean and sum of squares are weighted by the number 
+  // of observations per bin:
+  if (data_target->getNumberOfBins() > 0) {
+    data_target->bin_data_mat = arma::pow(data_target->createBins(data_source->getSourceData()), degree);
+    
+    arma::mat temp_mat(1, 2, arma::fill::zeros);
+    
+    if (intercept) {
+      temp_mat(0,0) = arma::accu(data_target->bin_counts % data_target->bin_data_mat) / arma::accu(data_target->bin_counts);
+    }
+    temp_mat(0,1) = arma::accu(data_target->bin_counts % arma::pow(data_target->bin_data_mat - temp_mat(0,0), 2));
+    data_target->XtX_inv = temp_mat;
+    
+    return;
+  }
+  
   // Prepare computation of intercept and slope of an ordinary linear regression:
-  if (data_source->getData().n_cols == 1) {
+  if (data_source->getSourceData().n_cols == 1) {
     // Store centered x values for faster computation:
-    data_target->setData(arma::pow(data_source->getData(), degree));
+    data_target->setData(arma::pow(data_source->getSourceData(), degree));
 
     // Hack to store some properties which are reused over and over again:
     arma::mat temp_mat(1, 2, arma::fill::zeros);
@@ -108,13 +270,35 @@ BaselearnerPolynomialFactory::BaselearnerPolynomialFactory (const std::string& b
 
   } else {
     // Get the data of the source, transform it and write it into the target:
-    data_target->setData(instantiateData(data_source->getData()));
+    data_target->setData(instantiateData(data_source->getSourceData()));
     data_target->XtX_inv = arma::inv(data_target->getData().t() * data_target->getData());
   }
   
   // blearner_type = blearner_type + " with degree " + std::to_string(degree);
 }
 
+/**
+ * \brief Restore the factory of a saved model
+ * 
+ * The target just contains the data identifier and an empty matrix with the
+ * number of features, which is enough to create base-learner and to predict
+ * new data. There is no data source and no training data.
+ * 
+ * \param blearner_type0 `std::string` Name of the baselearner type
+ * \param data_target0 `data::Data*` Target restored by `loadFactory()`
+ * \param degree `unsigned int` Polynomial degree
+ * \param intercept `bool` Flag if an intercept is used
+ */
+BaselearnerPolynomialFactory::BaselearnerPolynomialFactory (const std::string& blearner_type0, 
+  data::Data* data_target0, const unsigned int& degree, const bool& intercept)
+  : degree ( degree ),
+    intercept ( intercept )
+{
+  blearner_type = blearner_type0;
+  data_source   = NULL;
+  data_target   = data_target0;
+}
+
 blearner::Baselearner* BaselearnerPolynomialFactory::createBaselearner (const std::string& identifier)
 {
   blearner::Baselearner* blearner_obj;
@@ -178,7 +362,95 @@ arma::mat BaselearnerPolynomialFactory::instantiateData (const arma::mat& newdat
   return temp;
 }
 
+// Just univariate polynomials can be converted:
+bool BaselearnerPolynomialFactory::hasPiecewisePolynomial () const
+{
+  return data_target->getData().n_cols == 1;
+}
+
+// The effect is f(x) = a + b x^degree (or b x^degree without intercept):
+pwpolynomial::PiecewisePolynomial BaselearnerPolynomialFactory::toPiecewisePolynomial (const arma::mat& parameter) const
+{
+  if (! hasPiecewisePolynomial()) {
+    throw std::runtime_error("Polynomial base-learner of more than one feature can't be represented as piecewise polynomial.");
+  }
+  arma::vec coefficients(degree + 1, arma::fill::zeros);
+  if (intercept) {
+    coefficients[0]      += parameter(0);
+    coefficients[degree] += parameter(1);
+  } else {
+    coefficients[degree] += parameter(0);
+  }
+  return pwpolynomial::polynomialToPiecewisePolynomial(coefficients);
+}
+
+void BaselearnerPolynomialFactory::saveFactory (std::ostream& out) const
+{
+  serialize::writeString(out, "polynomial");
+  serialize::writeString(out, blearner_type);
+  serialize::writeString(out, data_target->getDataIdentifier());
+  serialize::writeUInt(out, degree);
+  serialize::writeUInt(out, intercept);
+  serialize::writeUInt(out, data_target->getData().n_cols);
+}
+
+// Binned features are trained on the sums per bin:
+unsigned int BaselearnerPolynomialFactory::getCrossprodSize () const
+{
+  if (data_target->hasBinnedData()) { return 0; }
+  return data_target->data_mat.n_cols;
+}
+
+void BaselearnerPolynomialFactory::addCrossprodBlock (const arma::vec& response, const unsigned int& first,
+  const unsigned int& last, arma::vec& crossprod) const
+{
+  addDenseCrossprodBlock(data_target->data_mat, response, first, last, crossprod);
+}
+
+// The target of one feature just stores the feature, the intercept is added
+// as first column (as by `instantiateData()`):
+unsigned int BaselearnerPolynomialFactory::getSubsampleSize () const
+{
+  if (data_target->hasBinnedData()) { return 0; }
+  if (data_target->data_mat.n_cols == 1 && intercept) { return 2; }
+  return data_target->data_mat.n_cols;
+}
+
+void BaselearnerPolynomialFactory::addSubsampleBlock (const arma::vec& response, const arma::uvec& row_idx, 
+  const arma::vec& weights, const unsigned int& first, const unsigned int& last, arma::vec& crossprod, 
+  arma::mat& gram) const
+{
+  arma::mat design;
+  if (row_idx.n_elem > 0) {
+    design = data_target->data_mat.rows(row_idx.subvec(first, last));
+  } else {
+    design = data_target->data_mat.rows(first, last);
+  }
+  if (design.n_cols == 1 && intercept) {
+    design = arma::join_rows(arma::mat(design.n_rows, 1, arma::fill::ones), design);
+  }
+  crossprod += design.t() * response.subvec(first, last);
+  if (weights.n_elem > 0) {
+    gram += design.t() * (design.each_col() % weights.subvec(first, last));
+  } else {
+    gram += design.t() * design;
+  }
+}
 
+DesignBlock BaselearnerPolynomialFactory::getDesignBlock (const unsigned int& first, const unsigned int& last) const
+{
+  DesignBlock block;
+  block.design = data_target->data_mat.rows(first, last);
+  if (block.design.n_cols == 1 && intercept) {
+    block.design = arma::join_rows(arma::mat(block.design.n_rows, 1, arma::fill::ones), block.design);
+  }
+  return block;
+}
+
+bool BaselearnerPolynomialFactory::isLinearSmoother () const
+{
+  return true;
+}
 
 // BaselearnerPSpline:
 // -----------------------
@@ -222,7 +494,7 @@ BaselearnerPSplineFactory::BaselearnerPSplineFactory (const std::string& blearne
   // This is necessary to prevent the program from segfolds... whyever???
   // Copied from: http://lists.r-forge.r-project.org/pipermail/rcpp-devel/2012-November/004796.html
   try {
-    if (data_source->getData().n_cols > 1) {
+    if (data_source->getSourceData().n_cols > 1) {
       Rcpp::stop("Given data should have just one column.");
     }
   } catch ( std::exception &ex ) {
@@ -230,27 +502,150 @@ BaselearnerPSplineFactory::BaselearnerPSplineFactory (const std::string& blearne
   } catch (...) { 
     ::Rf_error( "c++ exception (unknown reason)" ); 
   }
-  // Initialize knots:
-  data_target->knots = createKnots(data_source->getData(), n_knots, degree);
   
-  // Additionally set the penalty matrix:
-  data_target->penalty_mat = penaltyMat(n_knots + (degree + 1), differences);
+  // The preparation tag just describes the basis but not the penalty. Hence,
+  // factories on the same feature with different penalties share the target:
+  std::stringstream tag;
+  tag << "pspline;degree=" << degree << ";n_knots=" << n_knots << ";sparse=" << use_sparse_matrices 
+      << ";float=" << data_target->usesSinglePrecision() << ";bins=" << data_target->getNumberOfBins() 
+      << ";chunked=" << data_target->isChunked() << ";" << serialize::fingerprint(data_source->getSourceData());
+  data_target->checkPreparation(tag.str());
+  
+  // Skip the preparation if the target was restored by `loadData()` or is
+  // already prepared by another factory:
+  if (data_target->getPreparationTag() == tag.str()) {
+    data_target->setDataIdentifier(data_source->getDataIdentifier());
+    data_target->convertToSinglePrecision();
+  } else {
+    data_target->setPreparationTag(tag.str());
+    prepareTarget();
+  }
+  data_target->markAsUsedByFactory();
+  
+  // The penalty is added by each factory. The inverse is computed when the 
+  // setup is finished (see `finishSetup()`):
+  penalty_mat      = penaltyMat(n_knots + (degree + 1), differences);
+  setup_is_pending = true;
+}
+
+/**
+ * \brief Constructor with multiple penalties
+ * 
+ * The basis and its cross product are prepared once (as for one penalty).
+ * Additionally, the Demmler-Reinsch decomposition of the cross product and
+ * the penalty matrix is computed. The base-learner use it to compute the
+ * solutions of all penalties from one \f$X^T r\f$ and choose one of them
+ * in every training.
+ * 
+ * \param penalties `arma::vec` Regularization parameters to choose from
+ */
+BaselearnerPSplineFactory::BaselearnerPSplineFactory (const std::string& blearner_type0, 
+  data::Data* data_source0, data::Data* data_target0, const unsigned int& degree, 
+  const unsigned int& n_knots, const arma::vec& penalties, const unsigned int& differences,
+  const bool& use_sparse_matrices)
+  : BaselearnerPSplineFactory (blearner_type0, data_source0, data_target0, degree, n_knots, 
+      penalties.min(), differences, use_sparse_matrices)
+{
+  if (penalties.n_elem < 2) { return; }
+  
+  // The decomposition is computed when the setup is finished:
+  penalty_candidates.penalties = penalties;
+}
+
+/**
+ * \brief Write the basis and its cross product into the target
+ * 
+ * Depending on the target, the basis is stored in memory (sparse or dense),
+ * per bin, or in chunks on disk.
+ */
+void BaselearnerPSplineFactory::prepareTarget ()
+{
+  const arma::mat& raw_data = data_source->getSourceData();
+  
+  // Initialize knots:
+  data_target->knots = createKnots(raw_data, n_knots, degree);
   
   // Make sure that the data identifier is setted correctly:
   data_target->setDataIdentifier(data_source->getDataIdentifier());
   
+  // Out-of-core target: The basis is created and written chunk by chunk, 
+  // hence the full basis is never in memory. Just the small cross product is
+  // accumulated over the chunks:
+  if (data_target->isChunked()) {
+    data::ChunkedData* chunked_target = static_cast<data::ChunkedData*>(data_target);
+    
+    unsigned int n_cols = n_knots + (degree + 1);
+    data_target->XtX = arma::mat (n_cols, n_cols, arma::fill::zeros);
+    
+    chunked_target->startChunks(n_cols, degree + 1);
+    for (unsigned int first = 0; first < raw_data.n_rows; first += chunked_target->getChunkSize()) {
+      unsigned int last = std::min<unsigned int>(first + chunked_target->getChunkSize(), raw_data.n_rows) - 1;
+      arma::sp_mat basis_t = createSparseSplineBasis(raw_data.rows(first, last), degree, data_target->knots).t();
+      
+      data_target->XtX += basis_t * basis_t.t();
+      chunked_target->appendChunk(basis_t);
+    }
+    chunked_target->finishChunks();
+    
+    return;
+  }
+  
+  // Binned feature, the basis is just computed for the values of the bins.
+  // The cross product of the full basis weights each bin by its number of
+  // observations:
+  if (data_target->getNumberOfBins() > 0) {
+    data_target->bin_data_mat = createSplineBasis(data_target->createBins(raw_data), degree, data_target->knots);
+    
+    arma::mat weighted_basis = data_target->bin_data_mat.each_col() % data_target->bin_counts;
+    data_target->XtX = data_target->bin_data_mat.t() * weighted_basis;
+    
+    return;
+  }
+  
   // Get the data of the source, transform it and write it into the target. This needs some explanations:
   //   - If we use sparse matrices we want to store the sparse matrix into the sparse data matrix member of
   //     the data object. This also requires to adopt getData() for that purpose.
   //   - To get some (very) nice speed ups we store the transposed matrix not the standard one. This also 
   //     affects how the training in baselearner.cpp is done. Nevertheless, this speed up things dramatically.
   if (use_sparse_matrices) {
-    data_target->sparse_data_mat = createSparseSplineBasis (data_source->getData(), degree, data_target->knots).t();
-    data_target->XtX_inv = arma::inv(data_target->sparse_data_mat * data_target->sparse_data_mat.t() + penalty * data_target->penalty_mat);
+    data_target->sparse_data_mat = createSparseSplineBasis (raw_data, degree, data_target->knots).t();
+    data_target->XtX = arma::mat (data_target->sparse_data_mat * data_target->sparse_data_mat.t());
   } else {
-    data_target->setData(instantiateData(data_source->getData()));
-    data_target->XtX_inv = arma::inv(data_target->getData().t() * data_target->getData() + penalty * data_target->penalty_mat);
+    data_target->setData(instantiateData(raw_data));
+    data_target->XtX = data_target->getData().t() * data_target->getData();
   } 
+  // The cross product is computed in double before the basis is converted
+  // (if requested by the target):
+  data_target->convertToSinglePrecision();
+}
+
+/**
+ * \brief Restore the factory of a saved model
+ * 
+ * The knots must already be set in the target. Neither the basis nor the 
+ * penalty matrix are created since the factory is just used for prediction.
+ * 
+ * \param blearner_type0 `std::string` Name of the baselearner type
+ * \param data_target0 `data::Data*` Target restored by `loadFactory()`
+ * \param degree `unsigned int` Polynomial degree of the splines
+ * \param n_knots `unsigned int` Number of inner knots used 
+ * \param penalty `double` Regularization parameter
+ * \param differences `unsigned int` Number of differences used for the 
+ *   penalty matrix
+ * \param use_sparse_matrices `bool` Flag if sparse matrices were used
+ */
+BaselearnerPSplineFactory::BaselearnerPSplineFactory (const std::string& blearner_type0, 
+  data::Data* data_target0, const unsigned int& degree, const unsigned int& n_knots, 
+  const double& penalty, const unsigned int& differences, const bool& use_sparse_matrices)
+  : degree ( degree ),
+    n_knots ( n_knots ),
+    penalty ( penalty ),
+    differences ( differences ),
+    use_sparse_matrices ( use_sparse_matrices )
+{
+  blearner_type = blearner_type0;
+  data_source   = NULL;
+  data_target   = data_target0;
 }
 
 /**
@@ -262,10 +657,17 @@ blearner::Baselearner* BaselearnerPSplineFactory::createBaselearner (const std::
 {
   blearner::Baselearner* blearner_obj;
   
+  // Factories which are not registered in a list finish their setup here:
+  if (setup_is_pending) { finishSetup(); }
+  
   // Create new polynomial baselearner. This one will be returned by the 
   // factory:
-  blearner_obj = new blearner::BaselearnerPSpline(data_target, identifier, degree,
-    n_knots, penalty, differences, use_sparse_matrices);
+  blearner::BaselearnerPSpline* blearner_spline = new blearner::BaselearnerPSpline(data_target, 
+    identifier, degree, n_knots, penalty, differences, use_sparse_matrices, &XtX_inv, &penalty_mat);
+  if (penalty_candidates.penalties.n_elem > 1) {
+    blearner_spline->setPenaltyCandidates(&penalty_candidates);
+  }
+  blearner_obj = blearner_spline;
   blearner_obj->setBaselearnerType(blearner_type);
   
   // // Check if the data is already set. If not, run 'instantiateData' from the
@@ -281,6 +683,201 @@ blearner::Baselearner* BaselearnerPSplineFactory::createBaselearner (const std::
   return blearner_obj;
 }
 
+/**
+ * \brief Specify the degrees of freedom instead of the penalty
+ * 
+ * The penalty \f$\lambda\f$ is chosen such that 
+ * \f$\mathrm{tr}((X^T X + \lambda K)^{-1} X^T X) = \mathrm{df}\f$. It is
+ * computed from the Demmler-Reinsch orthogonalization when the setup is 
+ * finished. Since the differences of the penalty are not penalized, the 
+ * degrees of freedom must be larger than the number of differences.
+ * 
+ * \param df `double` Degrees of freedom of the base-learner
+ */
+void BaselearnerPSplineFactory::setDegreesOfFreedom (const double& df)
+{
+  if (penalty_candidates.penalties.n_elem > 1) {
+    Rcpp::stop("The degrees of freedom can't be combined with multiple penalties.");
+  }
+  if (! setup_is_pending) {
+    Rcpp::stop("The degrees of freedom can't be set after the base-learner is used.");
+  }
+  unsigned int n_cols = n_knots + (degree + 1);
+  if (df <= differences || df > n_cols) {
+    Rcpp::stop("The degrees of freedom must be larger than the number of differences (" + 
+      std::to_string(differences) + ") and smaller or equal to the number of basis functions (" + 
+      std::to_string(n_cols) + ").");
+  }
+  degrees_of_freedom = df;
+  setup_is_pending   = true;
+}
+
+double BaselearnerPSplineFactory::getPenalty ()
+{
+  if (setup_is_pending) {
+    try {
+      finishSetup();
+    } catch ( std::exception &ex ) {
+      forward_exception_to_r( ex );
+    }
+  }
+  return penalty;
+}
+
+bool BaselearnerPSplineFactory::hasPendingSetup () const
+{
+  return setup_is_pending;
+}
+
+/**
+ * \brief Compute the inverse of the penalized cross product
+ * 
+ * If the degrees of freedom or multiple penalties are used, then the 
+ * Demmler-Reinsch orthogonalization is computed once. With the degrees of 
+ * freedom, the penalty is found from its eigenvalues and the inverse is just
+ * a scaled cross product of the orthogonalized basis. The function is called
+ * from the worker threads of `BaselearnerFactoryList::finishFactorySetup()`,
+ * hence errors are thrown as `std::runtime_error`.
+ */
+void BaselearnerPSplineFactory::finishSetup ()
+{
+  if (degrees_of_freedom > 0 || penalty_candidates.penalties.n_elem > 1) {
+    arma::mat dr_basis;
+    arma::vec dr_eigenvalues;
+    if (! demmlerReinsch(data_target->XtX, penalty_mat, dr_basis, dr_eigenvalues)) {
+      throw std::runtime_error("The Demmler-Reinsch decomposition of the spline factory failed.");
+    }
+    if (degrees_of_freedom > 0) {
+      penalty = demmlerReinschPenalty(dr_eigenvalues, degrees_of_freedom);
+      XtX_inv = dr_basis * arma::diagmat(1 / (1 + penalty * dr_eigenvalues)) * dr_basis.t();
+    } else {
+      penalty_candidates.dr_basis       = dr_basis;
+      penalty_candidates.dr_eigenvalues = dr_eigenvalues;
+    }
+  }
+  if (degrees_of_freedom == 0) {
+    if (! arma::inv(XtX_inv, data_target->XtX + penalty * penalty_mat)) {
+      throw std::runtime_error("The penalized cross product of the spline factory is singular.");
+    }
+  }
+  setup_is_pending = false;
+}
+
+// Just bases which are in memory (and in double precision) are included into
+// the sweep, the other layouts compute X^T r by their own:
+unsigned int BaselearnerPSplineFactory::getCrossprodSize () const
+{
+  if (data_target->isChunked() || data_target->hasBinnedData() || data_target->hasSinglePrecisionData()) {
+    return 0;
+  }
+  return data_target->XtX.n_rows;
+}
+
+void BaselearnerPSplineFactory::addCrossprodBlock (const arma::vec& response, const unsigned int& first,
+  const unsigned int& last, arma::vec& crossprod) const
+{
+  if (use_sparse_matrices) {
+    addSparseCrossprodBlock(data_target->sparse_data_mat, response, first, last, crossprod);
+  } else {
+    addDenseCrossprodBlock(data_target->data_mat, response, first, last, crossprod);
+  }
+}
+
+unsigned int BaselearnerPSplineFactory::getSubsampleSize () const
+{
+  return getCrossprodSize();
+}
+
+// The sparse basis is stored transposed, hence the rows of the subsample are
+// columns with just `degree + 1` non zero elements. The weighted X^T W X is 
+// banded and accumulated from these elements:
+void BaselearnerPSplineFactory::addSubsampleBlock (const arma::vec& response, const arma::uvec& row_idx, 
+  const arma::vec& weights, const unsigned int& first, const unsigned int& last, arma::vec& crossprod, 
+  arma::mat& gram) const
+{
+  bool use_weights = weights.n_elem > 0;
+  if (! use_sparse_matrices) {
+    arma::mat design;
+    if (row_idx.n_elem > 0) {
+      design = data_target->data_mat.rows(row_idx.subvec(first, last));
+    } else {
+      design = data_target->data_mat.rows(first, last);
+    }
+    crossprod += design.t() * response.subvec(first, last);
+    if (use_weights) {
+      gram += design.t() * (design.each_col() % weights.subvec(first, last));
+    } else {
+      gram += design.t() * design;
+    }
+    return;
+  }
+  const arma::sp_mat& basis_t = data_target->sparse_data_mat;
+  basis_t.sync();
+  
+  for (unsigned int i = first; i <= last; i++) {
+    unsigned int row = row_idx.n_elem > 0 ? row_idx[i] : i;
+    unsigned int col_start = basis_t.col_ptrs[row];
+    unsigned int col_end   = basis_t.col_ptrs[row + 1];
+    double weight = use_weights ? weights[i] : 1;
+    
+    for (unsigned int j = col_start; j < col_end; j++) {
+      crossprod[basis_t.row_indices[j]] += basis_t.values[j] * response[i];
+      double weighted_value = weight * basis_t.values[j];
+      for (unsigned int l = col_start; l < col_end; l++) {
+        gram(basis_t.row_indices[j], basis_t.row_indices[l]) += weighted_value * basis_t.values[l];
+      }
+    }
+  }
+}
+
+/**
+ * \brief Predict on the training data
+ * 
+ * Chunked targets are streamed chunk by chunk, binned and single precision 
+ * targets are multiplied in their compressed form. Hence, the dense design
+ * matrix of `getData()` is never created.
+ * 
+ * \param parameter `arma::mat` parameter of the base-learner
+ * 
+ * \returns `arma::vec` prediction with one element per row
+ */
+arma::vec BaselearnerPSplineFactory::predictData (const arma::mat& parameter) const
+{
+  if (data_target->isChunked()) {
+    return static_cast<data::ChunkedData*>(data_target)->multiplyChunks(parameter);
+  }
+  if (data_target->hasBinnedData()) {
+    return data_target->multiplyBins(parameter);
+  }
+  if (data_target->hasSinglePrecisionData()) {
+    return data_target->multiplySinglePrecision(parameter);
+  }
+  if (use_sparse_matrices) {
+    return (parameter.t() * data_target->sparse_data_mat).t();
+  }
+  return data_target->data_mat * parameter;
+}
+
+// The sparse basis is stored transposed, hence the rows of the block are columns:
+DesignBlock BaselearnerPSplineFactory::getDesignBlock (const unsigned int& first, const unsigned int& last) const
+{
+  DesignBlock block;
+  if (use_sparse_matrices) {
+    block.is_sparse = true;
+    block.design_t  = data_target->sparse_data_mat.cols(first, last);
+  } else {
+    block.design = data_target->data_mat.rows(first, last);
+  }
+  return block;
+}
+
+// The hat matrix has eigenvalues 1 / (1 + penalty * s) in [0, 1]. With 
+// multiple penalties the penalty changes with the response:
+bool BaselearnerPSplineFactory::isLinearSmoother () const
+{
+  return penalty_candidates.penalties.n_elem < 2;
+}
+
 /**
  * \brief Data getter which always returns an arma::mat
  * 
@@ -296,8 +893,15 @@ blearner::Baselearner* BaselearnerPSplineFactory::createBaselearner (const std::
  */
 arma::mat BaselearnerPSplineFactory::getData () const
 {
+  if (data_target->isChunked() || data_target->hasBinnedData()) {
+    // Reads all chunks or expands the bins, just meant for small data:
+    return data_target->getData();
+  }
   if (use_sparse_matrices) {
     // std::cout << "Use sparse matrices" << std::endl;
+    if (data_target->hasSinglePrecisionData()) {
+      return arma::conv_to<arma::mat>::from(arma::fmat(data_target->sparse_data_mat_float.t()));
+    }
     arma::mat out (data_target->sparse_data_mat.t());
     return out;
   } else {
@@ -326,6 +930,43 @@ arma::mat BaselearnerPSplineFactory::instantiateData (const arma::mat& newdata)
   return createSplineBasis (newdata, degree, data_target->knots);
 }
 
+bool BaselearnerPSplineFactory::hasPiecewisePolynomial () const
+{
+  return true;
+}
+
+/**
+ * \brief Convert spline parameter to piecewise polynomial
+ * 
+ * The returned piecewise polynomial evaluates exactly the same function as
+ * `instantiateData(newdata) * parameter` (up to rounding errors, see 
+ * `piecewise_polynomial.h`) but just needs one span lookup and a Horner 
+ * scheme per new observation.
+ * 
+ * \param parameter `arma::mat` Parameter (e.g. the cumulated parameter of
+ *   the model) of the splines.
+ * 
+ * \returns `pwpolynomial::PiecewisePolynomial` of the fitted spline.
+ */
+pwpolynomial::PiecewisePolynomial BaselearnerPSplineFactory::toPiecewisePolynomial (const arma::mat& parameter) const
+{
+  arma::vec parameter_vec(parameter);
+  return pwpolynomial::splineToPiecewisePolynomial(parameter_vec, degree, data_target->knots);
+}
+
+void BaselearnerPSplineFactory::saveFactory (std::ostream& out) const
+{
+  serialize::writeString(out, "pspline");
+  serialize::writeString(out, blearner_type);
+  serialize::writeString(out, data_target->getDataIdentifier());
+  serialize::writeUInt(out, degree);
+  serialize::writeUInt(out, n_knots);
+  serialize::writeDouble(out, penalty);
+  serialize::writeUInt(out, differences);
+  serialize::writeUInt(out, use_sparse_matrices);
+  serialize::writeMat(out, data_target->knots);
+}
+
 // BaselearnerCustom:
 // -----------------------
 
@@ -385,6 +1026,11 @@ arma::mat BaselearnerCustomFactory::instantiateData (const arma::mat& newdata) c
   return Rcpp::as<arma::mat>(out);
 }
 
+bool BaselearnerCustomFactory::usesRFunctions () const
+{
+  return true;
+}
+
 // BaselearnerCustomCpp:
 // -----------------------
 
@@ -445,4 +1091,51 @@ arma::mat BaselearnerCustomCppFactory::instantiateData (const arma::mat& newdata
   return instantiateDataFun0(newdata);
 }
 
+// -------------------------------------------------------------------------- //
+// Restore factories of saved models:
+// -------------------------------------------------------------------------- //
+
+/**
+ * \brief Create a factory written by `saveFactory()`
+ * 
+ * The target is filled with the metadata required for prediction (data
+ * identifier and knots). The caller keeps the ownership of the target.
+ * 
+ * \param in `std::istream` Stream positioned at the factory entry
+ * \param data_target `data::Data*` Empty target for the factory
+ * 
+ * \returns `BaselearnerFactory*` Factory which can create base-learner and 
+ *   predict new data but which has no training data.
+ */
+BaselearnerFactory* loadFactory (std::istream& in, data::Data* data_target)
+{
+  std::string kind          = serialize::readString(in);
+  std::string blearner_type = serialize::readString(in);
+  data_target->setDataIdentifier(serialize::readString(in));
+  
+  if (kind == "polynomial") {
+    unsigned int degree = serialize::readUInt(in);
+    bool intercept      = serialize::readUInt(in);
+    unsigned int n_cols = serialize::readUInt(in);
+    
+    // The number of features decides if the effect is univariate:
+    data_target->setData(arma::mat(0, n_cols));
+    
+    return new BaselearnerPolynomialFactory(blearner_type, data_target, degree, intercept);
+  }
+  if (kind == "pspline") {
+    unsigned int degree      = serialize::readUInt(in);
+    unsigned int n_knots     = serialize::readUInt(in);
+    double penalty           = serialize::readDouble(in);
+    unsigned int differences = serialize::readUInt(in);
+    bool use_sparse_matrices = serialize::readUInt(in);
+    data_target->knots       = serialize::readMat(in);
+    
+    return new BaselearnerPSplineFactory(blearner_type, data_target, degree, n_knots, 
+      penalty, differences, use_sparse_matrices);
+  }
+  Rcpp::stop("Unknown base-learner factory '" + kind + "' in saved model.");
+  return NULL;
+}
+
 } // namespace blearnerfactory
@@ -59,13 +59,39 @@
 
 #include <iostream>
 #include <string>
+#include <iomanip> // ::setprecision
 
 #include "baselearner.h"
 #include "data.h"
 #include "splines.h"
+#include "piecewise_polynomial.h"
 
 namespace blearnerfactory {
 
+// -------------------------------------------------------------------------- //
+// Block of rows of a design matrix:
+// -------------------------------------------------------------------------- //
+
+// Sparse bases are kept sparse and transposed (one column per row) as they
+// are stored within the data target. The products are computed for any 
+// combination of dense and sparse blocks:
+
+struct DesignBlock
+{
+  bool is_sparse = false;
+  arma::mat design;
+  arma::sp_mat design_t;
+  
+  /// \f$X^T r\f$ with the rows of the block of r
+  arma::vec crossprod (const arma::vec&) const;
+  
+  /// \f$X^T X\f$
+  arma::mat gram () const;
+  
+  /// \f$X^T Y\f$ with the block Y of another design matrix
+  arma::mat crossGram (const DesignBlock&) const;
+};
+
 // -------------------------------------------------------------------------- //
 // Abstract 'BaselearnerFactory' class:
 // -------------------------------------------------------------------------- //
@@ -87,6 +113,56 @@ public:
   
   void initializeDataObjects (data::Data*, data::Data*);
   
+  // Univariate factories can represent a fitted effect as piecewise 
+  // polynomial of the raw feature which is used for fast prediction:
+  virtual bool hasPiecewisePolynomial () const;
+  virtual pwpolynomial::PiecewisePolynomial toPiecewisePolynomial (const arma::mat&) const;
+  
+  // Tag if the factory calls R functions (those can't be used outside the 
+  // main thread, e.g. for asynchronous training):
+  virtual bool usesRFunctions () const;
+  
+  // Factories with linear base-learners provide blocks of X^T r. The optimizer
+  // computes all cross products in one sweep over the rows of the response,
+  // hence the response is just read once per iteration. A size of zero means
+  // that the base-learner is trained on the response:
+  virtual unsigned int getCrossprodSize () const;
+  virtual void addCrossprodBlock (const arma::vec&, const unsigned int&, const unsigned int&, 
+    arma::vec&) const;
+  
+  // Same for a subsample of the rows (given by the indices, empty for all 
+  // rows), additionally X^T W X is accumulated with the weights of the rows
+  // (empty for equal weights). A size of zero means that the factory can't 
+  // be trained on a subsample or with weights:
+  virtual unsigned int getSubsampleSize () const;
+  virtual void addSubsampleBlock (const arma::vec&, const arma::uvec&, const arma::vec&, 
+    const unsigned int&, const unsigned int&, arma::vec&, arma::mat&) const;
+  
+  // Prediction X b on the training data. By default the design matrix of
+  // `getData()` is used, factories with chunked or compressed targets 
+  // multiply without creating the dense design matrix:
+  virtual arma::vec predictData (const arma::mat&) const;
+  
+  // Block of rows of the design matrix used by `addSubsampleBlock()`. The 
+  // cross products between the design matrices of two factories are 
+  // accumulated from these blocks (see `OptimizerCachedCoordinateDescent`):
+  virtual DesignBlock getDesignBlock (const unsigned int&, const unsigned int&) const;
+  
+  // Linear smoother with a hat matrix H whose SSE reduction r^T (2H - H^T H) r
+  // is a squared semi norm bounded by r^T r (used to skip factories, see 
+  // `OptimizerLazyCoordinateDescent`):
+  virtual bool isLinearSmoother () const;
+  
+  // Expensive parts of the setup (e.g. matrix decompositions) can be deferred
+  // until all factories are registered. The list then finishes the setup of 
+  // all factories in parallel, hence `finishSetup()` must not use the R API:
+  virtual bool hasPendingSetup () const;
+  virtual void finishSetup ();
+  
+  // Write the configuration which is required to predict with the factory
+  // into a saved model (see `loadFactory()`):
+  virtual void saveFactory (std::ostream&) const;
+  
   // Destructor:
   virtual ~BaselearnerFactory ();
   
@@ -118,12 +194,38 @@ public:
   BaselearnerPolynomialFactory (const std::string&, data::Data*, data::Data*, const unsigned int&,
     const bool&);
   
+  /// Restore the factory of a saved model without any training data
+  BaselearnerPolynomialFactory (const std::string&, data::Data*, const unsigned int&, const bool&);
+  
   blearner::Baselearner* createBaselearner (const std::string&);
   
   /// Get data used for modeling
   arma::mat getData() const;
   
   arma::mat instantiateData (const arma::mat&) const;
+  
+  /// Polynomials of one feature are piecewise polynomials with one piece
+  bool hasPiecewisePolynomial () const;
+  pwpolynomial::PiecewisePolynomial toPiecewisePolynomial (const arma::mat&) const;
+  
+  /// Write degree, intercept, and the number of features
+  void saveFactory (std::ostream&) const;
+  
+  /// Cross product of the (dense) data with the response
+  unsigned int getCrossprodSize () const;
+  void addCrossprodBlock (const arma::vec&, const unsigned int&, const unsigned int&, 
+    arma::vec&) const;
+  
+  /// Cross products of a subsample, the intercept is added as column
+  unsigned int getSubsampleSize () const;
+  void addSubsampleBlock (const arma::vec&, const arma::uvec&, const arma::vec&, 
+    const unsigned int&, const unsigned int&, arma::vec&, arma::mat&) const;
+  
+  /// Rows of the data with the intercept column (as for the subsample)
+  DesignBlock getDesignBlock (const unsigned int&, const unsigned int&) const;
+  
+  /// Least squares fit is a projection
+  bool isLinearSmoother () const;
 };
 
 // BaselearnerPSplineFactory:
@@ -145,8 +247,12 @@ private:
   /// Number of inner knots
   const unsigned int n_knots;
   
-  /// Regularization parameter
-  const double penalty;
+  /// Regularization parameter, computed from the degrees of freedom if they
+  /// are specified
+  double penalty;
+  
+  /// Degrees of freedom used to compute the penalty (zero if not used)
+  double degrees_of_freedom = 0;
   
   /// Order of differences used for penalty matrix
   const unsigned int differences;
@@ -154,6 +260,20 @@ private:
   /// Flag if sparse matrices should be used:
   const bool use_sparse_matrices;
   
+  /// Penalty matrix and inverse of the penalized cross product, the target
+  /// with the basis can be shared with factories using other penalties
+  arma::mat penalty_mat;
+  arma::mat XtX_inv;
+  
+  /// Multiple penalties which are shared by the base-learners
+  blearner::PenaltyCandidates penalty_candidates;
+  
+  /// Flag if the inverse (and the decomposition) is not yet computed
+  bool setup_is_pending = false;
+  
+  /// Write the basis and its cross product into the target
+  void prepareTarget ();
+  
 public:
 
   /// Default constructor of class `PSplineBleanrerFactory`
@@ -161,14 +281,61 @@ public:
     const unsigned int&, const unsigned int&, const double&, 
     const unsigned int&, const bool&);
   
+  /// Factory which chooses the penalty in every training from a vector of penalties
+  BaselearnerPSplineFactory (const std::string&, data::Data*, data::Data*, 
+    const unsigned int&, const unsigned int&, const arma::vec&, 
+    const unsigned int&, const bool&);
+  
+  /// Restore the factory of a saved model, the target just contains the knots
+  BaselearnerPSplineFactory (const std::string&, data::Data*, const unsigned int&, 
+    const unsigned int&, const double&, const unsigned int&, const bool&);
+  
   /// Create new `BaselearnerPSpline` object
   blearner::Baselearner* createBaselearner (const std::string&);
   
+  /// Compute the penalty from the degrees of freedom when the setup is finished
+  void setDegreesOfFreedom (const double&);
+  
+  /// Get the penalty (the setup is finished if necessary)
+  double getPenalty ();
+  
+  /// Compute the inverse of the penalized cross product (without R API)
+  bool hasPendingSetup () const;
+  void finishSetup ();
+  
+  /// Cross product of the in memory basis with the response
+  unsigned int getCrossprodSize () const;
+  void addCrossprodBlock (const arma::vec&, const unsigned int&, const unsigned int&, 
+    arma::vec&) const;
+  
+  /// Cross products of a subsample of the in memory basis
+  unsigned int getSubsampleSize () const;
+  void addSubsampleBlock (const arma::vec&, const arma::uvec&, const arma::vec&, 
+    const unsigned int&, const unsigned int&, arma::vec&, arma::mat&) const;
+  
+  /// Prediction on the training data without the dense design matrix
+  arma::vec predictData (const arma::mat&) const;
+  
+  /// Rows of the in memory basis (sparse bases stay sparse)
+  DesignBlock getDesignBlock (const unsigned int&, const unsigned int&) const;
+  
+  /// Penalized least squares with one penalty
+  bool isLinearSmoother () const;
+  
   /// Get data used for modelling
   arma::mat getData() const;
 
   /// Instantiate the design matrix
   arma::mat instantiateData (const arma::mat&) const;
+  
+  /// Splines are always univariate and can be converted to piecewise polynomials
+  bool hasPiecewisePolynomial () const;
+  
+  /// Convert spline parameter to piecewise polynomial
+  pwpolynomial::PiecewisePolynomial toPiecewisePolynomial (const arma::mat&) const;
+  
+  /// Write the spline configuration and the knots
+  void saveFactory (std::ostream&) const;
 };
 
 // BaselearnerCustomFactory:
@@ -197,6 +364,9 @@ public:
   
   arma::mat instantiateData (const arma::mat&) const;
   
+  /// The custom factory calls `R` functions
+  bool usesRFunctions () const;
+  
 };
 
 // BaselearnerCustomCppFactory:
@@ -227,6 +397,13 @@ public:
   
 };
 
+// -------------------------------------------------------------------------- //
+// Restore factories of saved models:
+// -------------------------------------------------------------------------- //
+
+/// Create a factory written by `saveFactory()`, the target must be empty
+BaselearnerFactory* loadFactory (std::istream&, data::Data*);
+
 } // namespace blearnerfactory
 
 #endif // BASELEARNERFACTORY_H_
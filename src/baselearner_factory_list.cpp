@@ -85,6 +85,47 @@ void BaselearnerFactoryList::clearMap ()
   my_factory_map.clear();
 }
 
+// Finish the setup of all factories which have deferred it (e.g. the 
+// decompositions of the spline factories). The factories are independent, 
+// hence they are distributed over threads which pick the next pending factory.
+// Errors are collected and reported after all threads are joined since the R
+// API can just be used from the main thread:
+void BaselearnerFactoryList::finishFactorySetup () const
+{
+  std::vector<blearnerfactory::BaselearnerFactory*> pending_factories;
+  for (auto& it : my_factory_map) {
+    if (it.second->hasPendingSetup()) { pending_factories.push_back(it.second); }
+  }
+  if (pending_factories.size() == 0) { return; }
+  
+  unsigned int n_threads = std::max(1u, std::thread::hardware_concurrency());
+  n_threads = std::min<unsigned int>(n_threads, pending_factories.size());
+  
+  std::atomic<unsigned int> next_factory (0);
+  std::vector<std::string> errors (n_threads);
+  
+  auto finishPendingFactories = [&] (const unsigned int thread_id) {
+    unsigned int i;
+    while ((i = next_factory++) < pending_factories.size()) {
+      try {
+        pending_factories[i]->finishSetup();
+      } catch (const std::exception& ex) {
+        if (errors[thread_id].empty()) { errors[thread_id] = ex.what(); }
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < n_threads; t++) {
+    threads.push_back(std::thread(finishPendingFactories, t));
+  }
+  finishPendingFactories(0);
+  for (auto& thread : threads) { thread.join(); }
+  
+  for (auto& error : errors) {
+    if (! error.empty()) { Rcpp::stop(error); }
+  }
+}
+
 std::pair<std::vector<std::string>, arma::mat> BaselearnerFactoryList::getModelFrame () const
 {
   arma::mat out_matrix;
@@ -37,6 +37,8 @@
 #define BASELEARNERLIST_H_
 
 #include <map>
+#include <thread>
+#include <atomic>
 
 #include "baselearner_factory.h"
 
@@ -71,6 +73,9 @@ public:
   // Clear all elements wich are registered:
   void clearMap();
   
+  // Finish the deferred setup of all factories in parallel:
+  void finishFactorySetup () const;
+  
   // Get the data used for modelling:
   std::pair<std::vector<std::string>, arma::mat> getModelFrame () const;
 
@@ -46,35 +46,64 @@ BaselearnerTrack::BaselearnerTrack (double learning_rate) : learning_rate ( lear
 // Insert a baselearner to the vector. We also want to add up the parameter
 // in there to get an estimator in the end:
 void BaselearnerTrack::insertBaselearner (blearner::Baselearner* blearner)
+{
+  insertBaselearner(blearner, 0);
+}
+
+void BaselearnerTrack::insertBaselearner (blearner::Baselearner* blearner, const double& momentum)
 {
   // Insert new baselearner:
   blearner_vector.push_back(blearner);
+  momentum_vector.push_back(momentum);
   
-  std::string insert_id = blearner->getDataIdentifier() + "_" + blearner->getBaselearnerType();
-  // std::cout << "Insert base-learner with base-learner id: " << blearner->getBaselearnerType() << std::endl;;
+  addUpdate(my_parameter_map, my_update_map, blearner, momentum);
+}
 
-  // Check if the baselearner is the first one. If so, the parameter
-  // has to be instantiated with a zero matrix:
-  std::map<std::string, arma::mat>::iterator it = my_parameter_map.find(insert_id);
+// Accumulate the update of one iteration. The update is the parameter of the
+// base-learner shrunken by the learning rate plus the momentum times the 
+// update of the previous iteration (which may contain other factories):
+void BaselearnerTrack::addUpdate (std::map<std::string, arma::mat>& parameter_map, 
+  std::map<std::string, arma::mat>& update_map, blearner::Baselearner* blearner, 
+  const double& momentum) const
+{
+  std::string insert_id = blearner->getDataIdentifier() + "_" + blearner->getBaselearnerType();
   
   // Prune parameter by multiplying it with the learning rate:
   arma::mat parameter_temp = learning_rate * blearner->getParameter();
   
-  // Check if this is the first parameter entry:
-  if (it == my_parameter_map.end()) {
-    
-    // If this is the first entry, initialize it with zeros:
-    arma::mat init_parameter(parameter_temp.n_rows, parameter_temp.n_cols, arma::fill::zeros);
-    my_parameter_map.insert(std::pair<std::string, arma::mat>(insert_id, init_parameter));
-
+  if (momentum == 0) {
+    update_map.clear();
+    update_map[insert_id] = parameter_temp;
+  } else {
+    for (auto& it : update_map) {
+      it.second *= momentum;
+    }
+    std::map<std::string, arma::mat>::iterator it_update = update_map.find(insert_id);
+    if (it_update == update_map.end()) {
+      update_map[insert_id] = parameter_temp;
+    } else {
+      it_update->second += parameter_temp;
+    }
   }
   
-  // Accumulating parameter. If there is a nan, then this will be ignored and 
-  // the non  nan entries are added up:
-  // arma::mat parameter_insert = parameter_temp + my_parameter_map.find(blearner->getBaselearnerType())->second;
-  // my_parameter_map.insert(std::pair<std::string, arma::mat>(blearner->getBaselearnerType(), parameter_insert));
-  my_parameter_map[ insert_id ] = parameter_temp + my_parameter_map.find(insert_id)->second;
-  
+  // Accumulating parameter. If this is the first entry of a factory, it is 
+  // initialized with the update:
+  for (auto& it : update_map) {
+    std::map<std::string, arma::mat>::iterator it_parameter = parameter_map.find(it.first);
+    if (it_parameter == parameter_map.end()) {
+      parameter_map.insert(std::pair<std::string, arma::mat>(it.first, it.second));
+    } else {
+      it_parameter->second += it.second;
+    }
+  }
+}
+
+bool BaselearnerTrack::usesMomentum () const
+{
+  for (auto& it : momentum_vector) {
+    if (it != 0) { return true; }
+  }
+  return false;
 }
 
 // Get the vector of baselearner:
@@ -97,6 +126,8 @@ void BaselearnerTrack::clearBaselearnerVector ()
     delete blearner_vector[i];
   } 
   blearner_vector.clear();
+  momentum_vector.clear();
+  my_update_map.clear();
 }
 
 // Get estimated parameter for specific iteration:
@@ -108,32 +139,10 @@ std::map<std::string, arma::mat> BaselearnerTrack::getEstimatedParameterOfIterat
   
   // Create new parameter map:
   std::map<std::string, arma::mat> my_new_parameter_map;
+  std::map<std::string, arma::mat> my_new_update_map;
   
-  if (k <= blearner_vector.size()) {
-    
-    for (unsigned int i = 0; i < k; i++) {
-      std::string insert_id = blearner_vector[i]->getDataIdentifier() + "_" + blearner_vector[i]->getBaselearnerType();
-      
-      // Check if the baselearner is the first one. If so, the parameter
-      // has to be instantiated with a zero matrix:
-      std::map<std::string, arma::mat>::iterator it = my_new_parameter_map.find(insert_id);
-      
-      // Prune parameter by multiplying it with the learning rate:
-      arma::mat parameter_temp = learning_rate * blearner_vector[i]->getParameter();
-      
-      // Check if this is the first parameter entry:
-      if (it == my_new_parameter_map.end()) {
-        
-        // If this is the first entry, initialize it with zeros:
-        arma::mat init_parameter(parameter_temp.n_rows, parameter_temp.n_cols, arma::fill::zeros);
-        my_new_parameter_map.insert(std::pair<std::string, arma::mat>(insert_id, init_parameter));
-        
-      }
-      
-      // Accumulating parameter. If there is a nan, then this will be ignored and 
-      // the non  nan entries are added up:
-      my_new_parameter_map[ insert_id ] = parameter_temp + my_new_parameter_map.find(insert_id)->second;
-    }
+  for (unsigned int i = 0; i < k; i++) {
+    addUpdate(my_new_parameter_map, my_new_update_map, blearner_vector[i], momentum_vector[i]);
   }
   return my_new_parameter_map;
 }
@@ -159,16 +168,10 @@ std::pair<std::vector<std::string>, arma::mat> BaselearnerTrack::getParameterMat
 
   // Initialize matrix:
   arma::mat parameters (blearner_vector.size(), cols, arma::fill::zeros);
+  std::map<std::string, arma::mat> my_new_update_map;
     
   for (unsigned int i = 0; i < blearner_vector.size(); i++) {
-    std::string insert_id = blearner_vector[i]->getDataIdentifier() + "_" + blearner_vector[i]->getBaselearnerType();
-
-    // Prune parameter by multiplying it with the learning rate:
-    arma::mat parameter_temp = learning_rate * blearner_vector[i]->getParameter();
-    
-    // Accumulating parameter. If there is a nan, then this will be ignored and 
-    // the non  nan entries are added up:
-    my_new_parameter_map[ insert_id ] = parameter_temp + my_new_parameter_map.find(insert_id)->second;
+    addUpdate(my_new_parameter_map, my_new_update_map, blearner_vector[i], momentum_vector[i]);
     
     arma::mat param_insert;
     
@@ -205,9 +208,16 @@ void BaselearnerTrack::setToIteration (const unsigned int& k)
     Rcpp::stop ("You can't set the actual state to a higher state then the maximal iterations.");
   }
   
+  // The update map belongs to the maximal iteration, from which a resumed 
+  // training continues:
   my_parameter_map = getEstimatedParameterOfIteration(k);
 }
 
+void BaselearnerTrack::setParameterMap (const std::map<std::string, arma::mat>& parameter_map)
+{
+  my_parameter_map = parameter_map;
+}
+
 // Destructor:
 BaselearnerTrack::~BaselearnerTrack ()
 {
@@ -56,13 +56,28 @@ class BaselearnerTrack
     
     double learning_rate;
     
+    // Momentum of every iteration (accelerated training) and the last update
+    // of the parameter of every factory. Without momentum, the update is just
+    // the shrunken parameter of the selected base-learner:
+    std::vector<double> momentum_vector;
+    std::map<std::string, arma::mat> my_update_map;
+    
+    // Add the update of one iteration to a parameter map:
+    void addUpdate (std::map<std::string, arma::mat>&, std::map<std::string, arma::mat>&, 
+      blearner::Baselearner*, const double&) const;
+    
   public: 
     
     BaselearnerTrack ();
     BaselearnerTrack (double);
     
-    // Insert a baselearner into vector and update parameter:
+    // Insert a baselearner into vector and update parameter. The second 
+    // argument is the momentum of the iteration (zero without acceleration):
     void insertBaselearner (blearner::Baselearner*);
+    void insertBaselearner (blearner::Baselearner*, const double&);
+    
+    // Tag if any iteration used a momentum:
+    bool usesMomentum () const;
     
     // Return the vector of baselearner:
     std::vector<blearner::Baselearner*> getBaselearnerVector () const;
@@ -82,6 +97,9 @@ class BaselearnerTrack
     // Set parameter map to a given iteration:
     void setToIteration (const unsigned int&);
     
+    // Restore the parameter map of a saved model (without base-learners):
+    void setParameterMap (const std::map<std::string, arma::mat>&);
+    
     // Destructor:
     ~BaselearnerTrack ();
 };
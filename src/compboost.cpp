@@ -58,66 +58,210 @@ Compboost::Compboost (const arma::vec& response, const double& learning_rate,
 {
   blearner_track = blearnertrack::BaselearnerTrack(learning_rate);
   used_logger["initial.training"] = used_logger0;
+  
+  // All factories are registered now, hence the deferred setups can run in 
+  // parallel:
+  used_baselearner_list.finishFactorySetup();
+}
+
+/**
+ * \brief Restore a model written by `saveModel()`
+ * 
+ * The restored model owns its loss, factories, and data targets. Neither 
+ * the training data, the design matrices, nor the parameter of every 
+ * iteration are part of the file, hence the model can't be trained further
+ * or set to another iteration and the inbag prediction is not available.
+ * Everything else (parameter, selection counts, risk, and prediction on new
+ * data) behaves as for the saved model.
+ * 
+ * \param file_name `std::string` path of the model file
+ */
+Compboost::Compboost (const std::string& file_name)
+  : used_optimizer ( NULL ),
+    used_loss ( NULL )
+{
+  model_is_loaded = true;
+  used_logger["initial.training"] = new loggerlist::LoggerList();
+  
+  // The destructor isn't called if the constructor fails, hence we have to 
+  // clean up here:
+  try {
+    loadModel(file_name);
+  } catch (...) {
+    deleteLoadedComponents();
+    throw;
+  }
 }
 
 // --------------------------------------------------------------------------- #
 // Member functions:
 // --------------------------------------------------------------------------- #
 
-void Compboost::train (const unsigned int& trace, const arma::vec& prediction, loggerlist::LoggerList* logger)
+// Versions of the prediction are unique over all models, hence an optimizer
+// which is shared by two models doesn't mix up their statistics:
+static unsigned int newPredictionVersion ()
+{
+  static std::atomic<unsigned int> last_version {0};
+  return ++last_version;
+}
+
+void Compboost::train (const unsigned int& trace, const arma::vec& prediction, loggerlist::LoggerList* logger,
+  const unsigned int& start_iteration)
 {
 
+  // The training can run in a background thread which must not call the `R`
+  // API, hence errors are thrown as `std::exception`:
   if (used_baselearner_list.getMap().size() == 0) {
-    Rcpp::stop("Could not train without any registered base-learner.");
+    throw std::runtime_error("Could not train without any registered base-learner.");
   }
   
   arma::vec pred_temp = prediction;
   
+  // Statistics of the optimizer follow the prediction of the last iteration:
+  used_optimizer->setPredictionVersion(prediction_version, start_iteration - 1);
+  
+  // The momentum starts from scratch if the acceleration is activated after 
+  // the initial training:
+  if (use_acceleration && momentum_update.n_elem != pred_temp.n_elem) {
+    momentum_update.zeros(pred_temp.n_elem);
+    momentum_lambda = 0;
+  }
+  
   // Declare variables to stop the algorithm:
   bool stop_the_algorithm = false;
-  unsigned int k = 1;
+  unsigned int k = start_iteration;
+  
+  // Checkpoints are just written for the initial training since a resumed
+  // training continues with the logger of the initial training:
+  bool write_checkpoints = (checkpoint_file != "") && (logger == used_logger.find("initial.training")->second);
+  if (write_checkpoints) {
+    checkpoint_last_iteration = k - 1;
+    checkpoint_last_time = std::chrono::steady_clock::now();
+  }
   
   // Main Algorithm. While the stop criteria isn't fullfilled, run the 
   // algorithm:
   while (! stop_the_algorithm) {
     
-    // Define pseudo residuals as negative gradient:
-    pseudo_residuals = -used_loss->definedGradient(response, pred_temp);
+    // Pause or cancel requested by the R session (asynchronous training). A
+    // cancelled training keeps the model of the last finished iteration:
+    while (pause_training && ! cancel_training) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    if (cancel_training) {
+      break;
+    }
+    
+    // Accelerated training: The momentum follows Nesterov's sequence and the
+    // gradient is taken at the prediction plus the momentum times the last
+    // update of the prediction:
+    double momentum = 0;
+    arma::vec pred_momentum;
+    if (use_acceleration) {
+      double momentum_lambda_next = (1 + std::sqrt(1 + 4 * momentum_lambda * momentum_lambda)) / 2;
+      if (momentum_lambda > 1) {
+        momentum = (momentum_lambda - 1) / momentum_lambda_next;
+      }
+      momentum_lambda = momentum_lambda_next;
+      pred_momentum = pred_temp + momentum * momentum_update;
+    }
+    const arma::vec& pred_gradient = use_acceleration ? pred_momentum : pred_temp;
+    
+    // Define pseudo residuals as negative gradient (just for the subsample
+    // of the rows if the rows are subsampled):
+    arma::uvec row_idx;
+    arma::vec weights;
+    if (row_fraction < 1) {
+      row_idx = drawRows();
+      arma::vec response_subsample   = response.elem(row_idx);
+      arma::vec prediction_subsample = pred_gradient.elem(row_idx);
+      pseudo_residuals = -used_loss->definedGradient(response_subsample, prediction_subsample);
+      if (use_newton_steps) {
+        weights = used_loss->definedHessian(response_subsample, prediction_subsample);
+      }
+    } else {
+      pseudo_residuals = -used_loss->definedGradient(response, pred_gradient);
+      if (use_newton_steps) {
+        weights = used_loss->definedHessian(response, pred_gradient);
+      }
+    }
+    // Newton steps: The base-learners are fitted to the pseudo residuals 
+    // divided by the hessian with the hessian as weights. Rows with a 
+    // vanishing hessian would get an infinite pseudo response:
+    if (use_newton_steps) {
+      weights = arma::clamp(weights, 1e-10, arma::datum::inf);
+    }
     // Rcpp::Rcout << "\n<<Compboost>> Define pseudo residuals as negative gradient" << std::endl;
     
     // Cast integer k to string for baselearner identifier:
     std::string temp_string = std::to_string(k);
-    blearner::Baselearner* selected_blearner = used_optimizer->findBestBaselearner(temp_string, pseudo_residuals, used_baselearner_list.getMap());
+    blearner::Baselearner* selected_blearner = used_optimizer->findBestBaselearner(temp_string, pseudo_residuals, weights, 
+      row_idx, used_baselearner_list.getMap());
     // Rcpp::Rcout << "<<Compboost>> Cast integer k to string for baselearner identifier" << std::endl;
     
+    // Step size of the optimizer (e.g. a line search). The step is folded 
+    // into the parameter, hence the tracked parameter, the logger, and the
+    // prediction of any iteration stay consistent:
+    arma::vec blearner_prediction = selected_blearner->predict();
+    double step_size = used_optimizer->calculateStepSize(used_loss, response, pred_gradient, selected_blearner, blearner_prediction);
+    if (step_size != 1) {
+      selected_blearner->setParameter(step_size * selected_blearner->getParameter());
+      blearner_prediction *= step_size;
+    }
+    
     // Insert new baselearner to vector of selected baselearner:    
-    blearner_track.insertBaselearner(selected_blearner);
+    blearner_track.insertBaselearner(selected_blearner, momentum);
     // Rcpp::Rcout << "<<Compboost>> Insert new baselearner to vector of selected baselearner" << std::endl;
     
     // Update model (prediction) and shrink by learning rate:
-    pred_temp += learning_rate * selected_blearner->predict();
+    if (use_acceleration) {
+      momentum_update = momentum * momentum_update + learning_rate * blearner_prediction;
+      pred_temp += momentum_update;
+    } else {
+      pred_temp += learning_rate * blearner_prediction;
+    }
     // Rcpp::Rcout << "<<Compboost>> Update model (prediction) and shrink by learning rate" << std::endl;
     
+    // Optimizers which keep statistics of the pseudo residuals follow the 
+    // update of the prediction:
+    used_optimizer->updateStatistics(used_loss, selected_blearner, learning_rate, momentum);
+    
     // Log the current step:
     
     // The last term has to be the prediction or anything like that. This is
     // important to track the risk (inbag or oob)!!!!
     
     logger->logCurrent(k, response, pred_temp, selected_blearner, 
-      initialization, learning_rate);
+      initialization, learning_rate, momentum);
     // Rcpp::Rcout << "<<Compboost>> Log the current step" << std::endl;
     
-    // Calculate and log risk:
-    risk.push_back(arma::mean(used_loss->definedLoss(response, pred_temp)));
-
     // Get status of the algorithm (is stopping criteria reached):
     stop_the_algorithm = ! logger->getStopperStatus(stop_if_all_stopper_fulfilled);
     
+    // Calculate and log risk. The risk of all rows is just computed every 
+    // `risk_every` iterations, for the printed trace, and for the last 
+    // iteration. Skipped iterations are NaN as within the risk loggers:
+    bool print_trace = (trace > 0) && ((k == 1) || ((k % trace) == 0));
+    if ((k % risk_every == 0) || print_trace || stop_the_algorithm) {
+      risk.push_back(used_loss->calculateEmpiricalRisk(response, pred_temp));
+    } else {
+      risk.push_back(arma::datum::nan);
+    }
+    
+    // Write a checkpoint if the previous one is already written. Otherwise,
+    // it is tried again in the next iteration:
+    if (write_checkpoints && ! stop_the_algorithm && ! checkpoint_in_progress && checkpointIsDue(k)) {
+      writeCheckpoint(k, pred_temp, logger);
+    }
+    
     // Print trace:
-    if (trace > 0) {
-      if ((k == 1) || ((k % trace) == 0)) {
-        logger->printLoggerStatus(risk.back()); 
-      }
+    if (print_trace) {
+      logger->printLoggerStatus(risk.back()); 
+    }
+    
+    // Publish the progress instead of printing it (asynchronous training):
+    if (training_is_async) {
+      publishTrainingSnapshot(logger, false);
     }
     
     // Increment k:
@@ -130,17 +274,33 @@ void Compboost::train (const unsigned int& trace, const arma::vec& prediction, l
     Rcpp::Rcout << std::endl; 
   }
   
+  // The risk of the last iteration is always available (also if the training
+  // is cancelled):
+  if (std::isnan(risk.back())) {
+    risk.back() = used_loss->calculateEmpiricalRisk(response, pred_temp);
+  }
+  
+  // Wait for the last checkpoint:
+  joinCheckpoint();
+  
   // Set model prediction:
   model_prediction = pred_temp;
   
   // Set actual state to the latest iteration:
   actual_iteration = blearner_track.getBaselearnerVector().size();
+  
+  if (use_precompiled_prediction) {
+    precompilePrediction();
+  }
 }
 
-void Compboost::trainCompboost (const unsigned int& trace)
+arma::vec Compboost::initializeTraining ()
 {
   // Make sure, that the selected baselearner and logger data is empty:
   blearner_track.clearBaselearnerVector();
+  checkpoint_trace.clear();
+  checkpoint_trace_size = 0;
+  momentum_update.reset();
   for (auto& it : used_logger) {
     it.second->clearLoggerData();
   }
@@ -153,16 +313,25 @@ void Compboost::trainCompboost (const unsigned int& trace)
   // Initialize prediction and fill with zero model:
   arma::vec prediction(response.size());
   prediction.fill(initialization);
+  prediction_version = newPredictionVersion();
   // Rcpp::Rcout << "<<Compboost>> Initialize prediction and fill with zero model" << std::endl;
   
   // Calculate risk for initial model:
-  risk.push_back(arma::mean(used_loss->definedLoss(response, prediction)));
+  risk.push_back(used_loss->calculateEmpiricalRisk(response, prediction));
+  
+  return prediction;
+}
+
+void Compboost::trainCompboost (const unsigned int& trace)
+{
+  checkTrainable();
+  arma::vec prediction = initializeTraining();
 
   // track time:
   auto t1 = std::chrono::high_resolution_clock::now();
   
   // Initial training:
-  train(trace, prediction, used_logger["initial.training"]);
+  train(trace, prediction, used_logger["initial.training"], 1);
   
   // track time:
   auto t2 = std::chrono::high_resolution_clock::now();
@@ -176,6 +345,8 @@ void Compboost::trainCompboost (const unsigned int& trace)
   
   // Set flag if model is trained:
   model_is_trained = true;
+  
+  reportCheckpointError();
 }
 
 void Compboost::continueTraining (loggerlist::LoggerList* logger, const unsigned int& trace)
@@ -183,6 +354,7 @@ void Compboost::continueTraining (loggerlist::LoggerList* logger, const unsigned
   if (! model_is_trained) {
     Rcpp::stop("Initial training hasn't been done yet. Use 'train()' first.");
   }
+  checkTrainable();
   // Set state to maximal possible iteration to cleanly continue training:
   if (actual_iteration != blearner_track.getBaselearnerVector().size()) {
     
@@ -195,7 +367,7 @@ void Compboost::continueTraining (loggerlist::LoggerList* logger, const unsigned
   }
   
   // Continue training:
-  train(trace, model_prediction, logger);
+  train(trace, model_prediction, logger, 1);
   
   // Register logger in hash map to store logging data:
   std::string logger_id = "retraining" + std::to_string(used_logger.size());
@@ -205,8 +377,579 @@ void Compboost::continueTraining (loggerlist::LoggerList* logger, const unsigned
   actual_iteration = blearner_track.getBaselearnerVector().size();
 }
 
+/**
+ * \brief Train every iteration on a random subsample of the rows
+ * 
+ * The pseudo residuals, the training of the base-learners, and the selection
+ * just use a new subsample of `fraction * n` rows in every iteration. The
+ * prediction of all rows is updated with the selected base-learner. The
+ * subsample is drawn by a partial shuffle which just touches the rows of the
+ * subsample. The random numbers are not drawn from `R`, hence the training
+ * can also run in the background.
+ * 
+ * \param fraction `double` fraction of rows used in every iteration, a value
+ *   of one uses all rows
+ * \param seed `unsigned int` seed of the random number generator
+ */
+void Compboost::setRowSubsampling (const double& fraction, const unsigned int& seed)
+{
+  if (training_is_running) {
+    Rcpp::stop("The row subsampling can't be changed while the model is trained in the background.");
+  }
+  if (fraction <= 0 || fraction > 1) {
+    Rcpp::stop("The fraction of rows must be in (0, 1].");
+  }
+  row_fraction = fraction;
+  row_generator.seed(seed);
+  row_permutation.clear();
+  prediction_version = newPredictionVersion();
+}
+
+/**
+ * \brief Use Newton steps instead of gradient steps
+ * 
+ * In every iteration, the base-learners are fitted by weighted least squares
+ * to the negative gradient divided by the second derivative of the loss. The
+ * weights are the second derivatives. Hence, the selected base-learner is a
+ * Newton step within its subspace. The fit just requires X^T W X and X^T r,
+ * which are computed for all factories in one sweep over the rows (see 
+ * `BaselearnerFactory::addSubsampleBlock()`). The loss must provide the
+ * second derivative.
+ * 
+ * \param use_newton `bool` flag to activate the Newton steps
+ */
+void Compboost::setNewtonSteps (const bool& use_newton)
+{
+  if (training_is_running) {
+    Rcpp::stop("The Newton steps can't be changed while the model is trained in the background.");
+  }
+  if (use_newton && ! used_loss->hasHessian()) {
+    Rcpp::stop("The loss doesn't provide the second derivative which is required for Newton steps.");
+  }
+  use_newton_steps = use_newton;
+}
+
+/**
+ * \brief Compute the risk of all rows just every `every` iterations
+ * 
+ * The risk of the training data requires a pass over all rows and is 
+ * computed in every iteration by default. With a stride, the risk is also 
+ * computed for the printed trace and for the last iteration. The risk of 
+ * all other iterations is NaN.
+ * 
+ * \param every `unsigned int` number of iterations between two risks
+ */
+void Compboost::setRiskEvery (const unsigned int& every)
+{
+  if (training_is_running) {
+    Rcpp::stop("The stride of the risk can't be changed while the model is trained in the background.");
+  }
+  if (every == 0) {
+    Rcpp::stop("The risk must be computed at least every iteration, hence the stride must be greater than zero.");
+  }
+  risk_every = every;
+}
+
+/**
+ * \brief Accelerate the training by Nesterov's momentum
+ * 
+ * The accelerated training keeps the update of the prediction of the last
+ * iteration. The pseudo residuals are computed at the prediction plus the
+ * momentum times this update. The new update is the momentum times the last
+ * update plus the shrunken prediction of the selected base-learner. The 
+ * momentum of iteration \f$m\f$ is \f$(\lambda_{m-1} - 1) / \lambda_m\f$ with
+ * \f$\lambda_0 = 0\f$ and \f$\lambda_m = (1 + \sqrt{1 + 4\lambda_{m-1}^2}) / 2\f$.
+ * The momentum of every iteration is stored in the base-learner track, 
+ * hence the parameter of every iteration is still available. Checkpoints
+ * and saved models don't support the momentum.
+ * 
+ * \param use_momentum `bool` flag to activate the acceleration
+ */
+void Compboost::setAcceleration (const bool& use_momentum)
+{
+  if (training_is_running) {
+    Rcpp::stop("The acceleration can't be changed while the model is trained in the background.");
+  }
+  if (use_momentum && checkpoint_file != "") {
+    Rcpp::stop("The accelerated training can't write checkpoints.");
+  }
+  use_acceleration = use_momentum;
+}
+
+arma::uvec Compboost::drawRows ()
+{
+  unsigned int n_rows = response.n_elem;
+  if (row_permutation.size() != n_rows) {
+    row_permutation.resize(n_rows);
+    for (unsigned int i = 0; i < n_rows; i++) { row_permutation[i] = i; }
+  }
+  unsigned int n_subsample = std::max(1.0, std::ceil(row_fraction * n_rows));
+  
+  arma::uvec row_idx (n_subsample);
+  // The distributions of <random> are implementation defined, the modulo of
+  // the generator draws the same rows with every standard library:
+  for (unsigned int i = 0; i < n_subsample; i++) {
+    unsigned int j = i + row_generator() % (n_rows - i);
+    std::swap(row_permutation[i], row_permutation[j]);
+    row_idx[i] = row_permutation[i];
+  }
+  // Sorted rows are read sequentially from the design matrices:
+  return arma::sort(row_idx);
+}
+
+/**
+ * \brief Write checkpoints while training
+ * 
+ * While the initial training (also in the background) a checkpoint is 
+ * written every `every_iterations` iterations or every `every_seconds` 
+ * seconds, whatever comes first. A value of zero deactivates the 
+ * corresponding criteria, an empty file name deactivates the checkpoints.
+ * The checkpoint is first written into `file_name.tmp` and then renamed. 
+ * Hence, the file always contains a complete checkpoint, even if the 
+ * process is killed while writing.
+ * 
+ * \param file_name `std::string` path of the checkpoint file
+ * \param every_iterations `unsigned int` number of iterations between two 
+ *   checkpoints
+ * \param every_seconds `double` time in seconds between two checkpoints
+ */
+void Compboost::setCheckpoint (const std::string& file_name, const unsigned int& every_iterations,
+  const double& every_seconds)
+{
+  if (training_is_running) {
+    Rcpp::stop("The checkpoints can't be changed while the model is trained in the background.");
+  }
+  if (file_name != "" && every_iterations == 0 && every_seconds <= 0) {
+    Rcpp::stop("Specify how often checkpoints are written by the number of iterations or seconds.");
+  }
+  if (file_name != "" && use_acceleration) {
+    Rcpp::stop("The accelerated training can't write checkpoints.");
+  }
+  checkpoint_file             = file_name;
+  checkpoint_every_iterations = every_iterations;
+  checkpoint_every_seconds    = every_seconds;
+}
+
+bool Compboost::checkpointIsDue (const unsigned int& k) const
+{
+  if (checkpoint_every_iterations > 0 && k - checkpoint_last_iteration >= checkpoint_every_iterations) {
+    return true;
+  }
+  if (checkpoint_every_seconds > 0) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - checkpoint_last_time;
+    return elapsed.count() >= checkpoint_every_seconds;
+  }
+  return false;
+}
+
+/**
+ * \brief Serialize the state after iteration `k` and write it in the background
+ * 
+ * A checkpoint contains:
+ *   - Learning rate, offset, and the iteration `k`
+ *   - The prediction vector and the risk
+ *   - The state of the logger
+ *   - The selection trace, i.e. the factory and the parameter of every
+ *     selected base-learner
+ * 
+ * Just the new part of the trace is serialized, the trace of the previous 
+ * checkpoints is reused. The writing into the file is done by another 
+ * thread which doesn't call the `R` API.
+ * 
+ * \param k `unsigned int` current iteration
+ * \param prediction `arma::vec` prediction after iteration `k`
+ * \param logger `loggerlist::LoggerList*` logger list of the training
+ */
+void Compboost::writeCheckpoint (const unsigned int& k, const arma::vec& prediction, 
+  loggerlist::LoggerList* logger)
+{
+  // The previous writer is already finished:
+  joinCheckpoint();
+  
+  std::vector<blearner::Baselearner*> blearner_vector = blearner_track.getBaselearnerVector();
+  
+  std::ostringstream trace_buffer;
+  for (unsigned int i = checkpoint_trace_size; i < blearner_vector.size(); i++) {
+    serialize::writeString(trace_buffer, blearner_vector[i]->getDataIdentifier() + "_" + blearner_vector[i]->getBaselearnerType());
+    serialize::writeMat(trace_buffer, blearner_vector[i]->getParameter());
+  }
+  checkpoint_trace.append(trace_buffer.str());
+  checkpoint_trace_size = blearner_vector.size();
+  
+  // The logger and optimizer state are stored as string to be able to read
+  // the whole checkpoint before anything of the model is changed:
+  std::ostringstream logger_buffer;
+  logger->saveLoggerState(logger_buffer);
+  
+  std::ostringstream optimizer_buffer;
+  used_optimizer->saveOptimizerState(optimizer_buffer);
+  
+  // The subsample of the next iteration depends on the generator and the
+  // permutation of the partial shuffle:
+  std::ostringstream row_generator_state;
+  row_generator_state << row_generator;
+  
+  std::ostringstream buffer;
+  serialize::writeHeader(buffer, "CBCHECKPOINT", 2);
+  serialize::writeDouble(buffer, learning_rate);
+  serialize::writeDouble(buffer, initialization);
+  serialize::writeUInt(buffer, k);
+  serialize::writeMat(buffer, prediction);
+  serialize::writeMat(buffer, arma::conv_to<arma::vec>::from(risk));
+  serialize::writeString(buffer, logger_buffer.str());
+  serialize::writeString(buffer, optimizer_buffer.str());
+  serialize::writeDouble(buffer, row_fraction);
+  serialize::writeString(buffer, row_generator_state.str());
+  serialize::writeMat(buffer, arma::conv_to<arma::vec>::from(row_permutation));
+  serialize::writeUInt(buffer, checkpoint_trace_size);
+  
+  std::shared_ptr<std::string> content = std::make_shared<std::string>(buffer.str());
+  content->append(checkpoint_trace);
+  
+  checkpoint_last_iteration = k;
+  checkpoint_last_time = std::chrono::steady_clock::now();
+  checkpoint_in_progress = true;
+  
+  std::string file_name = checkpoint_file;
+  checkpoint_thread = std::thread([this, content, file_name] () {
+    std::string temp_file = file_name + ".tmp";
+    std::ofstream out (temp_file, std::ios::out | std::ios::binary);
+    out.write(content->data(), content->size());
+    out.close();
+    
+    if (! out) {
+      checkpoint_error = "Could not write checkpoint into file '" + temp_file + "'.";
+    } else if (std::rename(temp_file.c_str(), file_name.c_str()) != 0) {
+      checkpoint_error = "Could not rename checkpoint '" + temp_file + "' to '" + file_name + "'.";
+    }
+    checkpoint_in_progress = false;
+  });
+}
+
+void Compboost::joinCheckpoint ()
+{
+  if (checkpoint_thread.joinable()) {
+    checkpoint_thread.join();
+  }
+}
+
+// Errors of the writer are reported as warning since the model itself is fine:
+void Compboost::reportCheckpointError ()
+{
+  if (! checkpoint_error.empty()) {
+    std::string msg = checkpoint_error;
+    checkpoint_error.clear();
+    Rcpp::warning(msg);
+  }
+}
+
+/**
+ * \brief Resume the initial training from a checkpoint
+ * 
+ * The model must be defined exactly as the one which has written the 
+ * checkpoint (same response, learning rate, factories, and logger). The
+ * selected base-learner, the prediction, the risk, the state of the row 
+ * subsampling, and the logger and optimizer state are restored and the 
+ * training continues with the next iteration. Hence, the resumed model is 
+ * exactly the same as the one of an uninterrupted training.
+ * 
+ * \param file_name `std::string` path of the checkpoint file
+ * \param trace `unsigned int` print every `trace` iteration (0 means no 
+ *   printing)
+ */
+void Compboost::trainFromCheckpoint (const std::string& file_name, const unsigned int& trace)
+{
+  checkTrainable();
+  if (training_is_running) {
+    Rcpp::stop("The model is already trained in the background.");
+  }
+  if (use_acceleration) {
+    Rcpp::stop("The accelerated training can't be resumed from a checkpoint.");
+  }
+  std::ifstream in;
+  serialize::openInputFile(in, file_name);
+  
+  uint32_t version = serialize::readHeader(in, "CBCHECKPOINT");
+  if (version != 2) {
+    Rcpp::stop("Checkpoint '" + file_name + "' has version " + std::to_string(version) + " which is not supported.");
+  }
+  double saved_learning_rate = serialize::readDouble(in);
+  double saved_initialization = serialize::readDouble(in);
+  unsigned int saved_iteration = serialize::readUInt(in);
+  arma::vec saved_prediction = serialize::readMat(in);
+  std::vector<double> saved_risk = arma::conv_to<std::vector<double>>::from(serialize::readMat(in));
+  std::string saved_logger_state = serialize::readString(in);
+  std::string saved_optimizer_state = serialize::readString(in);
+  double saved_row_fraction = serialize::readDouble(in);
+  std::istringstream saved_row_generator_state (serialize::readString(in));
+  std::vector<unsigned int> saved_row_permutation = arma::conv_to<std::vector<unsigned int>>::from(serialize::readMat(in));
+  
+  std::mt19937 saved_row_generator;
+  saved_row_generator_state >> saved_row_generator;
+  if (saved_row_generator_state.fail()) {
+    Rcpp::stop("Checkpoint '" + file_name + "' is corrupted.");
+  }
+  
+  if (saved_learning_rate != learning_rate) {
+    Rcpp::stop("The checkpoint was written with another learning rate.");
+  }
+  if (saved_row_fraction != row_fraction) {
+    Rcpp::stop("The checkpoint was written with another fraction of rows.");
+  }
+  if (saved_prediction.n_elem != response.n_elem) {
+    Rcpp::stop("The checkpoint was written for a response with " + std::to_string(saved_prediction.n_elem) 
+      + " observations but the model has " + std::to_string(response.n_elem) + ".");
+  }
+  
+  // Read the trace and check that all factories are registered:
+  blearner_factory_map factory_map = used_baselearner_list.getMap();
+  std::vector<blearnerfactory::BaselearnerFactory*> saved_factories;
+  std::vector<arma::mat> saved_parameter;
+  unsigned int n_iterations = serialize::readUInt(in);
+  if (n_iterations != saved_iteration) {
+    Rcpp::stop("Checkpoint '" + file_name + "' is corrupted.");
+  }
+  for (unsigned int i = 0; i < n_iterations; i++) {
+    std::string factory_id = serialize::readString(in);
+    blearner_factory_map::iterator it = factory_map.find(factory_id);
+    if (it == factory_map.end()) {
+      Rcpp::stop("Base-learner '" + factory_id + "' of the checkpoint isn't registered.");
+    }
+    saved_factories.push_back(it->second);
+    saved_parameter.push_back(serialize::readMat(in));
+  }
+  
+  // Restore the model:
+  std::istringstream optimizer_state (saved_optimizer_state);
+  used_optimizer->loadOptimizerState(optimizer_state);
+  prediction_version = newPredictionVersion();
+  
+  for (auto& it : used_logger) {
+    it.second->clearLoggerData();
+  }
+  std::istringstream logger_state (saved_logger_state);
+  used_logger["initial.training"]->loadLoggerState(logger_state);
+  
+  blearner_track.clearBaselearnerVector();
+  blearner_track = blearnertrack::BaselearnerTrack(learning_rate);
+  for (unsigned int i = 0; i < n_iterations; i++) {
+    blearner::Baselearner* blearner = saved_factories[i]->createBaselearner(std::to_string(i + 1));
+    blearner->setParameter(saved_parameter[i]);
+    blearner_track.insertBaselearner(blearner);
+  }
+  initialization = saved_initialization;
+  risk = saved_risk;
+  row_generator = saved_row_generator;
+  row_permutation = saved_row_permutation;
+  checkpoint_trace.clear();
+  checkpoint_trace_size = 0;
+  
+  train(trace, saved_prediction, used_logger["initial.training"], saved_iteration + 1);
+  model_is_trained = true;
+  
+  reportCheckpointError();
+}
+
+/**
+ * \brief Check if the model can be trained in a background thread
+ * 
+ * The training thread must not call the `R` API. Hence, custom losses or 
+ * base-learner which calls `R` functions are not allowed. The checks are 
+ * done in the main thread since `Rcpp::stop` also calls the `R` API.
+ * 
+ * \param logger `loggerlist::LoggerList*` logger list used for the training
+ */
+void Compboost::checkAsyncTraining (loggerlist::LoggerList* logger) const
+{
+  checkTrainable();
+  if (training_is_running) {
+    Rcpp::stop("The model is already trained in the background.");
+  }
+  if (used_baselearner_list.getMap().size() == 0) {
+    Rcpp::stop("Could not train without any registered base-learner.");
+  }
+  if (used_loss->usesRFunctions()) {
+    Rcpp::stop("Asynchronous training requires a loss implemented in C++, custom R losses are not allowed.");
+  }
+  for (auto& it : used_baselearner_list.getMap()) {
+    if (it.second->usesRFunctions()) {
+      Rcpp::stop("Asynchronous training requires base-learner implemented in C++, '" + it.first + "' calls R functions.");
+    }
+  }
+  if (logger->usesRFunctions()) {
+    Rcpp::stop("Asynchronous training requires logger which don't call R functions (e.g. by using a custom loss).");
+  }
+}
+
+/**
+ * \brief Run `train` in a background thread
+ * 
+ * The thread must not call the `R` API. Hence, everything called within the
+ * training throws `std::exception` instead of using `Rcpp::stop`. The 
+ * exception is stored and re-thrown as `R` error in the main thread by
+ * `joinTraining()`.
+ * 
+ * \param prediction `arma::vec` prediction to start with
+ * \param logger `loggerlist::LoggerList*` logger list used for the training
+ * \param is_initial_training `bool` flag to mark the model as trained
+ */
+void Compboost::startTrainingThread (const arma::vec& prediction, loggerlist::LoggerList* logger,
+  const bool& is_initial_training)
+{
+  // A finished thread must be joined before a new one can be assigned:
+  if (training_thread.joinable()) {
+    training_thread.join();
+  }
+  cancel_training = false;
+  pause_training = false;
+  training_exception = NULL;
+  training_is_async = true;
+  training_is_running = true;
+  
+  publishTrainingSnapshot(logger, true);
+  
+  training_thread = std::thread([this, prediction, logger, is_initial_training] () {
+    try {
+      train(0, prediction, logger, 1);
+      if (is_initial_training) {
+        model_is_trained = true;
+      }
+    } catch (...) {
+      training_exception = std::current_exception();
+    }
+    publishTrainingSnapshot(logger, true);
+    
+    cancel_training = false;
+    pause_training = false;
+    training_is_async = false;
+    training_is_running = false;
+  });
+}
+
+/**
+ * \brief Publish the current progress of the training
+ * 
+ * A new snapshot of the risk and logger data is created and swapped in 
+ * atomically. To keep the overhead low, this is done at most every 100 
+ * milliseconds if not forced.
+ * 
+ * \param logger `loggerlist::LoggerList*` logger list used for the training
+ * \param force `bool` publish the snapshot regardless of the time
+ */
+void Compboost::publishTrainingSnapshot (loggerlist::LoggerList* logger, const bool& force)
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (! force && (now - last_snapshot_time < std::chrono::milliseconds(100))) {
+    return;
+  }
+  last_snapshot_time = now;
+  
+  std::shared_ptr<TrainingSnapshot> snapshot = std::make_shared<TrainingSnapshot>();
+  snapshot->iteration   = blearner_track.getBaselearnerVector().size();
+  snapshot->risk        = risk;
+  snapshot->logger_data = logger->getLoggerData();
+  
+  std::atomic_store(&training_snapshot, std::shared_ptr<const TrainingSnapshot>(snapshot));
+}
+
+/**
+ * \brief Initial training in a background thread
+ * 
+ * The function returns immediately. The progress can be requested by 
+ * `getTrainingSnapshot()`, the training is finished when `isTrainingRunning()`
+ * returns `false`. Afterwards, `joinTraining()` must be called.
+ */
+void Compboost::trainCompboostAsync ()
+{
+  checkAsyncTraining(used_logger["initial.training"]);
+  
+  arma::vec prediction = initializeTraining();
+  startTrainingThread(prediction, used_logger["initial.training"], true);
+}
+
+/**
+ * \brief Continue training in a background thread
+ * 
+ * \param logger `loggerlist::LoggerList*` logger list used for the retraining
+ */
+void Compboost::continueTrainingAsync (loggerlist::LoggerList* logger)
+{
+  if (! model_is_trained) {
+    Rcpp::stop("Initial training hasn't been done yet. Use 'train()' first.");
+  }
+  checkAsyncTraining(logger);
+  
+  if (actual_iteration != blearner_track.getBaselearnerVector().size()) {
+    setToIteration(blearner_track.getBaselearnerVector().size());
+  }
+  std::string logger_id = "retraining" + std::to_string(used_logger.size());
+  used_logger[logger_id] = logger;
+  
+  startTrainingThread(model_prediction, logger, false);
+}
+
+bool Compboost::isTrainingRunning () const
+{
+  return training_is_running;
+}
+
+bool Compboost::isTrainingPaused () const
+{
+  return training_is_running && pause_training;
+}
+
+// Pausing and cancelling just affects a running training, otherwise the next
+// (synchronous) training would be stopped immediately:
+void Compboost::pauseTraining (const bool& pause)
+{
+  if (training_is_running) {
+    pause_training = pause;
+  }
+}
+
+void Compboost::cancelTraining ()
+{
+  if (training_is_running) {
+    cancel_training = true;
+  }
+}
+
+/**
+ * \brief Wait for the training thread and re-throw its errors
+ * 
+ * This blocks until the training is finished. Call `cancelTraining()` before
+ * to stop the training as soon as possible.
+ */
+void Compboost::joinTraining ()
+{
+  if (training_thread.joinable()) {
+    training_thread.join();
+  }
+  reportCheckpointError();
+  
+  if (training_exception) {
+    std::exception_ptr exception = training_exception;
+    training_exception = NULL;
+    try {
+      std::rethrow_exception(exception);
+    } catch (std::exception& e) {
+      Rcpp::stop(e.what());
+    } catch (...) {
+      Rcpp::stop("Unknown error while training in the background.");
+    }
+  }
+}
+
+std::shared_ptr<const TrainingSnapshot> Compboost::getTrainingSnapshot () const
+{
+  return std::atomic_load(&training_snapshot);
+}
+
 arma::vec Compboost::getPrediction (const bool& as_response) const
 {
+  if (model_is_loaded) {
+    Rcpp::stop("The prediction of the training data isn't stored within saved models.");
+  }
   arma::vec pred;
   if (as_response) {
     pred = used_loss->responseTransformation(model_prediction);
@@ -223,6 +966,7 @@ std::map<std::string, arma::mat> Compboost::getParameter () const
 
 std::vector<std::string> Compboost::getSelectedBaselearner () const
 {
+  checkTrace();
   std::vector<std::string> selected_blearner;
   
   for (unsigned int i = 0; i < actual_iteration; i++) {
@@ -231,6 +975,19 @@ std::vector<std::string> Compboost::getSelectedBaselearner () const
   return selected_blearner;
 }
 
+// Number of selections of every factory up to the actual iteration:
+std::map<std::string, unsigned int> Compboost::getSelectionCounts () const
+{
+  if (model_is_loaded) {
+    return loaded_selection_counts;
+  }
+  std::map<std::string, unsigned int> selection_counts;
+  for (auto& it : getSelectedBaselearner()) {
+    selection_counts[it] += 1;
+  }
+  return selection_counts;
+}
+
 std::map<std::string, loggerlist::LoggerList*> Compboost::getLoggerList () const
 {
   return used_logger;
@@ -239,11 +996,13 @@ std::map<std::string, loggerlist::LoggerList*> Compboost::getLoggerList () const
 std::map<std::string, arma::mat> Compboost::getParameterOfIteration (const unsigned int& k) const 
 {
   // Check is done in function GetEstimatedParameterOfIteration in baselearner_track.cpp 
+  checkTrace();
   return blearner_track.getEstimatedParameterOfIteration(k);
 }
 
 std::pair<std::vector<std::string>, arma::mat> Compboost::getParameterMatrix () const
 {
+  checkTrace();
   return blearner_track.getParameterMatrix();
 }
 
@@ -255,10 +1014,11 @@ arma::vec Compboost::predict () const
   arma::vec pred(model_prediction.n_elem);
   pred.fill(initialization);
   
-  // Calculate vector - matrix product for each selected base-learner:
+  // Calculate vector - matrix product for each selected base-learner (chunked
+  // targets are accumulated chunk by chunk):
   for (auto& it : parameter_map) {    
     std::string sel_factory = it.first;
-    pred += used_baselearner_list.getMap().find(sel_factory)->second->getData() * it.second;
+    pred += used_baselearner_list.getMap().find(sel_factory)->second->predictData(it.second);
     // pred += train_data_map.find(sel_factory)->second * it.second;    
   }
   return pred;
@@ -270,37 +1030,10 @@ arma::vec Compboost::predict () const
 // corresponding parameter.
 arma::vec Compboost::predict (std::map<std::string, data::Data*> data_map, const bool& as_response) const
 {
-  // IMPROVE THIS FUNCTION!!! See: 
-  // https://github.com/schalkdaniel/compboost/issues/206
-  
   std::map<std::string, arma::mat> parameter_map = blearner_track.getParameterMap();
-
-  arma::vec pred(data_map.begin()->second->getData().n_rows);
-  pred.fill(initialization);
   
-  // Rcpp::Rcout << "initialize pred vec" << std::endl;
+  arma::vec pred = predictNewdata(data_map, parameter_map, precompiled_effects, precompiled_factories);
   
-  // Idea is simply to calculate the vector matrix product of parameter and 
-  // newdata. The problem here is that the newdata comes as raw data and has
-  // to be transformed first:
-  for (auto& it : parameter_map) {
-    
-    // Name of current feature:
-    std::string sel_factory = it.first;
- 
-    // Find the element with key 'hat'
-    blearnerfactory::BaselearnerFactory* sel_factory_obj = used_baselearner_list.getMap().find(sel_factory)->second;
-      
-    // Select newdata corresponding to selected facotry object:
-    std::map<std::string, data::Data*>::iterator it_newdata;
-    it_newdata = data_map.find(sel_factory_obj->getDataIdentifier());
-
-    // Calculate prediction by accumulating the design matrices multiplied by the estimated parameter:
-    if (it_newdata != data_map.end()) {
-      arma::mat data_trafo = sel_factory_obj->instantiateData(it_newdata->second->getData());
-      pred += data_trafo * it.second;
-    }
-  }
   if (as_response) {
     pred = used_loss->responseTransformation(pred);
   }
@@ -309,32 +1042,84 @@ arma::vec Compboost::predict (std::map<std::string, data::Data*> data_map, const
 
 arma::vec Compboost::predictionOfIteration (std::map<std::string, data::Data*> data_map, const unsigned int& k, const bool& as_response) const
 {
-  // Rcpp::Rcout << "Get into Compboost::predict" << std::endl;
-  
   // Check is done in function GetEstimatedParameterOfIteration in baselearner_track.cpp 
-  std::map<std::string, arma::mat> parameter_map = blearner_track.getEstimatedParameterOfIteration(k);
+  std::map<std::string, arma::mat> parameter_map = getParameterOfIteration(k);
   
-  arma::vec pred(data_map.begin()->second->getData().n_rows);
+  // The precompiled effects belong to the actual iteration, hence we have to
+  // fold the effects of iteration k first:
+  std::map<std::string, pwpolynomial::PiecewisePolynomial> effects;
+  std::set<std::string> folded_factories;
+  
+  if (use_precompiled_prediction) {
+    foldUnivariateEffects(parameter_map, effects, folded_factories);
+  }
+  arma::vec pred = predictNewdata(data_map, parameter_map, effects, folded_factories);
+  
+  if (as_response) {
+    pred = used_loss->responseTransformation(pred);
+  }
+  return pred;
+}
+
+/**
+ * \brief Prediction of new data for a given parameter map
+ * 
+ * Features with folded univariate effects are read once and evaluated by 
+ * their piecewise polynomial. All other factories are predicted by 
+ * transforming the raw data into the design matrix and multiplying it with
+ * the parameter.
+ * 
+ * \param data_map `std::map<std::string, data::Data*>` Raw new data.
+ * \param parameter_map `std::map<std::string, arma::mat>` Parameter of the 
+ *   factories.
+ * \param effects `std::map<std::string, pwpolynomial::PiecewisePolynomial>` 
+ *   Folded effects per feature.
+ * \param folded_factories `std::set<std::string>` Factories which are 
+ *   already included in `effects`.
+ * 
+ * \returns `arma::vec` Prediction on the scale of the linear predictor.
+ */
+arma::vec Compboost::predictNewdata (std::map<std::string, data::Data*>& data_map, 
+  const std::map<std::string, arma::mat>& parameter_map, 
+  const std::map<std::string, pwpolynomial::PiecewisePolynomial>& effects,
+  const std::set<std::string>& folded_factories) const
+{
+  arma::vec pred(data_map.begin()->second->getSourceData().n_rows);
   pred.fill(initialization);
   
-  // Rcpp::Rcout << "initialize pred vec" << std::endl;
+  blearner_factory_map factory_map = used_baselearner_list.getMap();
   
+  // Each feature with folded effects is read and evaluated just once:
+  for (auto& it : effects) {
+    std::map<std::string, data::Data*>::iterator it_newdata = data_map.find(it.first);
+    
+    if (it_newdata != data_map.end()) {
+      pred += it.second.evaluate(it_newdata->second->getSourceData());
+    }
+  }
+  
+  // Idea is simply to calculate the vector matrix product of parameter and 
+  // newdata. The problem here is that the newdata comes as raw data and has
+  // to be transformed first:
   for (auto& it : parameter_map) {
     
+    // Name of current feature:
     std::string sel_factory = it.first;
     
-    // Rcpp::Rcout << "Fatory id of parameter map: " << sel_factory << std::endl;
+    if (folded_factories.find(sel_factory) != folded_factories.end()) { continue; }
     
-    blearnerfactory::BaselearnerFactory* sel_factory_obj = used_baselearner_list.getMap().find(sel_factory)->second;
-    
-    // Rcpp::Rcout << "Data of selected factory: " << sel_factory_obj->GetDataIdentifier() << std::endl;
+    // Find the element with key 'hat'
+    blearnerfactory::BaselearnerFactory* sel_factory_obj = factory_map.find(sel_factory)->second;
     
-    arma::mat data_trafo = sel_factory_obj->instantiateData((data_map.find(sel_factory_obj->getDataIdentifier())->second->getData()));
-    pred += data_trafo * it.second;
+    // Select newdata corresponding to selected facotry object:
+    std::map<std::string, data::Data*>::iterator it_newdata;
+    it_newdata = data_map.find(sel_factory_obj->getDataIdentifier());
     
-  }
-  if (as_response) {
-    pred = used_loss->responseTransformation(pred);
+    // Calculate prediction by accumulating the design matrices multiplied by the estimated parameter:
+    if (it_newdata != data_map.end()) {
+      arma::mat data_trafo = sel_factory_obj->instantiateData(it_newdata->second->getSourceData());
+      pred += data_trafo * it.second;
+    }
   }
   return pred;
 }
@@ -342,6 +1127,7 @@ arma::vec Compboost::predictionOfIteration (std::map<std::string, data::Data*> d
 // Set model to an given iteration. The predictions and everything is then done at this iteration:
 void Compboost::setToIteration (const unsigned int& k) 
 {
+  checkTrace();
   unsigned int max_iteration = blearner_track.getBaselearnerVector().size();
   
   // Set parameter:
@@ -364,11 +1150,84 @@ void Compboost::setToIteration (const unsigned int& k)
   
   blearner_track.setToIteration(k);
   
-  // Set prediction:
-  model_prediction = predict();
+  // Set prediction (loaded models don't have the training data):
+  if (! model_is_loaded) {
+    model_prediction = predict();
+  }
   
   // Set actual state:
   actual_iteration = k;
+  
+  if (use_precompiled_prediction) {
+    precompilePrediction();
+  }
+}
+
+/**
+ * \brief Use piecewise polynomials to predict univariate effects on new data
+ * 
+ * If this option is active, the cumulated parameter of every univariate 
+ * spline or polynomial factory are converted into piecewise polynomials and
+ * folded into one evaluator per feature after training (or setting the model
+ * to another iteration). Predicting new
+ * data then requires one span lookup and a Horner scheme per observation 
+ * instead of creating the basis and a matrix product. The prediction is exact
+ * up to rounding errors. Factories which can't be represented that way are
+ * still predicted by their design matrix.
+ * 
+ * \param use_precompiled `bool` Flag to activate or deactivate the precompiled
+ *   prediction.
+ */
+void Compboost::setPrecompiledPrediction (const bool& use_precompiled)
+{
+  use_precompiled_prediction = use_precompiled;
+  
+  if (use_precompiled_prediction) {
+    precompilePrediction();
+  } else {
+    precompiled_effects.clear();
+    precompiled_factories.clear();
+  }
+}
+
+void Compboost::precompilePrediction ()
+{
+  foldUnivariateEffects(blearner_track.getParameterMap(), precompiled_effects, precompiled_factories);
+}
+
+/**
+ * \brief Fold univariate effects into one piecewise polynomial per feature
+ * 
+ * Often more than one factory is registered on the same feature (e.g. a
+ * linear and a spline base-learner for `age`). All factories which can be
+ * represented as piecewise polynomial are grouped by their data identifier
+ * and their cumulated effects are added up. Hence, prediction just reads and
+ * evaluates each raw column once.
+ * 
+ * \param parameter_map `std::map<std::string, arma::mat>` Parameter of the 
+ *   factories.
+ * \param effects `std::map<std::string, pwpolynomial::PiecewisePolynomial>` 
+ *   Output map with one piecewise polynomial per data identifier.
+ * \param folded_factories `std::set<std::string>` Output set of factories
+ *   which are included in `effects`.
+ */
+void Compboost::foldUnivariateEffects (const std::map<std::string, arma::mat>& parameter_map, 
+  std::map<std::string, pwpolynomial::PiecewisePolynomial>& effects, 
+  std::set<std::string>& folded_factories) const
+{
+  effects.clear();
+  folded_factories.clear();
+  
+  blearner_factory_map factory_map = used_baselearner_list.getMap();
+  
+  for (auto& it : parameter_map) {
+    blearnerfactory::BaselearnerFactory* sel_factory_obj = factory_map.find(it.first)->second;
+    
+    if (sel_factory_obj->hasPiecewisePolynomial()) {
+      effects[sel_factory_obj->getDataIdentifier()].add(sel_factory_obj->toPiecewisePolynomial(it.second));
+      folded_factories.insert(it.first);
+    }
+  }
 }
 
 double Compboost::getOffset() const 
@@ -396,9 +1255,167 @@ void Compboost::summarizeCompboost () const
   Rcpp::Rcout << "To get more information check the other objects!" << std::endl;
 }
 
+void Compboost::checkTrainable () const
+{
+  if (model_is_loaded) {
+    Rcpp::stop("Loaded models can't be trained, they are just meant for prediction.");
+  }
+}
+
+void Compboost::checkTrace () const
+{
+  if (model_is_loaded) {
+    Rcpp::stop("Loaded models just contain the parameter of the saved iteration and how often each base-learner is selected.");
+  }
+}
+
+/**
+ * \brief Write the trained model into a binary file
+ * 
+ * The file contains everything which is required to predict new data:
+ *   - Learning rate, offset, actual iteration, and the type of the loss 
+ *     (for the response transformation)
+ *   - The risk vector
+ *   - The configuration of every factory with parameter, including the 
+ *     knots of the splines
+ *   - The estimated parameter of the actual iteration and how often the 
+ *     factory is selected
+ * 
+ * The size of the file doesn't grow with the parameter of every iteration.
+ * Hence, the selection trace is not restored and loaded models can't be set
+ * to another iteration. The training data and the design matrices are not
+ * stored.
+ * 
+ * \param file_name `std::string` path of the model file
+ */
+void Compboost::saveModel (const std::string& file_name) const
+{
+  if (! model_is_trained) {
+    Rcpp::stop("Initial training hasn't been done yet. Use 'train()' first.");
+  }
+  if (blearner_track.usesMomentum()) {
+    Rcpp::stop("Models trained with acceleration can't be saved.");
+  }
+  std::map<std::string, arma::mat> parameter_map = blearner_track.getParameterMap();
+  std::map<std::string, unsigned int> selection_counts = getSelectionCounts();
+  blearner_factory_map factory_map = used_baselearner_list.getMap();
+  
+  std::ofstream out;
+  serialize::openOutputFile(out, file_name);
+  
+  serialize::writeHeader(out, "CBMODEL", 2);
+  serialize::writeDouble(out, learning_rate);
+  serialize::writeDouble(out, initialization);
+  serialize::writeUInt(out, stop_if_all_stopper_fulfilled);
+  serialize::writeUInt(out, actual_iteration);
+  serialize::writeUInt(out, use_precompiled_prediction);
+  serialize::writeString(out, used_loss->getLossType());
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(risk));
+  
+  // Just the factories with parameter (the ones selected up to the actual 
+  // iteration) are required for prediction:
+  serialize::writeUInt(out, parameter_map.size());
+  for (auto& it : parameter_map) {
+    factory_map.find(it.first)->second->saveFactory(out);
+    serialize::writeUInt(out, selection_counts[it.first]);
+    serialize::writeMat(out, it.second);
+  }
+  
+  if (! out) {
+    Rcpp::stop("Could not write model into file '" + file_name + "'.");
+  }
+}
+
+/**
+ * \brief Read a model file written by `saveModel()`
+ * 
+ * \param file_name `std::string` path of the model file
+ */
+void Compboost::loadModel (const std::string& file_name)
+{
+  std::ifstream in;
+  serialize::openInputFile(in, file_name);
+  
+  uint32_t version = serialize::readHeader(in, "CBMODEL");
+  if (version != 2) {
+    Rcpp::stop("Model file '" + file_name + "' has version " + std::to_string(version) + " which is not supported.");
+  }
+  learning_rate  = serialize::readDouble(in);
+  initialization = serialize::readDouble(in);
+  stop_if_all_stopper_fulfilled = serialize::readUInt(in);
+  unsigned int saved_iteration  = serialize::readUInt(in);
+  bool saved_precompiled        = serialize::readUInt(in);
+  
+  // Just the response transformation is used for prediction. Custom losses
+  // are restored with the identity as response function:
+  std::string loss_type = serialize::readString(in);
+  if (loss_type == "absolute") {
+    used_loss = new loss::LossAbsolute();
+  } else if (loss_type == "binomial") {
+    used_loss = new loss::LossBinomial();
+  } else {
+    used_loss = new loss::LossQuadratic();
+  }
+  risk = arma::conv_to<std::vector<double>>::from(serialize::readMat(in));
+  
+  std::map<std::string, arma::mat> parameter_map;
+  unsigned int n_selected = 0;
+  unsigned int n_factories = serialize::readUInt(in);
+  for (unsigned int i = 0; i < n_factories; i++) {
+    data::Data* data_target = new data::InMemoryData();
+    loaded_data_targets.push_back(data_target);
+    
+    blearnerfactory::BaselearnerFactory* factory = blearnerfactory::loadFactory(in, data_target);
+    std::string factory_id = factory->getDataIdentifier() + "_" + factory->getBaselearnerType();
+    used_baselearner_list.registerBaselearnerFactory(factory_id, factory);
+    
+    loaded_selection_counts[factory_id] = serialize::readUInt(in);
+    parameter_map[factory_id] = serialize::readMat(in);
+    n_selected += loaded_selection_counts[factory_id];
+  }
+  if (n_selected != saved_iteration) {
+    Rcpp::stop("Model file '" + file_name + "' is corrupted.");
+  }
+  blearner_track = blearnertrack::BaselearnerTrack(learning_rate);
+  blearner_track.setParameterMap(parameter_map);
+  
+  model_is_trained = true;
+  actual_iteration = saved_iteration;
+  setPrecompiledPrediction(saved_precompiled);
+}
+
+void Compboost::deleteLoadedComponents ()
+{
+  blearner_track.clearBaselearnerVector();
+  
+  for (auto& it : used_baselearner_list.getMap()) {
+    delete it.second;
+  }
+  used_baselearner_list.clearMap();
+  
+  for (auto& it : loaded_data_targets) {
+    delete it;
+  }
+  loaded_data_targets.clear();
+  
+  delete used_loss;
+  used_loss = NULL;
+  
+  delete used_logger["initial.training"];
+  used_logger.clear();
+}
+
 // Destructor:
 Compboost::~Compboost ()
 {
+  // Stop a running training thread before the members are destroyed:
+  if (training_thread.joinable()) {
+    cancel_training = true;
+    pause_training = false;
+    training_thread.join();
+  }
+  joinCheckpoint();
+  
   // blearner_track will be deleted automatically (allocated on the stack)
   
   // used_logger will be deleted automatically (allocated on the stack). BUT we
@@ -409,6 +1426,10 @@ Compboost::~Compboost ()
       delete it.second;
     }
   }
+  
+  if (model_is_loaded) {
+    deleteLoadedComponents();
+  }
 }
 
 } // namespace cboost
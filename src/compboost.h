@@ -78,9 +78,30 @@
 #include "optimizer.h"
 #include "loss.h"
 #include "loggerlist.h"
+#include "piecewise_polynomial.h"
+
+#include <set>
+#include <cstdio>  // ::rename
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <stdexcept> // ::runtime_error
+#include <memory>
+#include <random>
 
 namespace cboost {
 
+// Progress of the training which is published by the training thread. A
+// snapshot is never modified after publishing, hence it can be read from the
+// R session while the training goes on:
+struct TrainingSnapshot
+{
+  unsigned int iteration = 0;
+  std::vector<double> risk;
+  std::pair<std::vector<std::string>, arma::mat> logger_data;
+};
+
 // Main class:
 
 class Compboost
@@ -112,6 +133,99 @@ private:
   // Vector of loggerlists, needed if one want to continue training:
   std::map<std::string, loggerlist::LoggerList*> used_logger;
   
+  // Precompiled univariate effects (one per feature) used for prediction on
+  // new data and the factories which are folded into these effects:
+  bool use_precompiled_prediction = false;
+  std::map<std::string, pwpolynomial::PiecewisePolynomial> precompiled_effects;
+  std::set<std::string> precompiled_factories;
+  
+  // Update the precompiled effects to the actual parameter:
+  void precompilePrediction ();
+  
+  void foldUnivariateEffects (const std::map<std::string, arma::mat>&, 
+    std::map<std::string, pwpolynomial::PiecewisePolynomial>&, std::set<std::string>&) const;
+  
+  arma::vec predictNewdata (std::map<std::string, data::Data*>&, const std::map<std::string, arma::mat>&, 
+    const std::map<std::string, pwpolynomial::PiecewisePolynomial>&, const std::set<std::string>&) const;
+  
+  // Asynchronous training. The flags are set from the R session and polled by
+  // the training thread in every iteration:
+  std::thread training_thread;
+  std::atomic<bool> training_is_running {false};
+  std::atomic<bool> training_is_async {false};
+  std::atomic<bool> cancel_training {false};
+  std::atomic<bool> pause_training {false};
+  std::exception_ptr training_exception = NULL;
+  
+  // Latest snapshot, swapped atomically to not block the training thread:
+  std::shared_ptr<const TrainingSnapshot> training_snapshot;
+  std::chrono::steady_clock::time_point last_snapshot_time;
+  
+  // Initialize offset, prediction, and risk of the initial training:
+  arma::vec initializeTraining ();
+  
+  // Version of the prediction which is passed to the optimizer. It changes
+  // if the prediction is computed anew, not by `setToIteration()`:
+  unsigned int prediction_version = 0;
+  
+  void checkAsyncTraining (loggerlist::LoggerList*) const;
+  void startTrainingThread (const arma::vec&, loggerlist::LoggerList*, const bool&);
+  void publishTrainingSnapshot (loggerlist::LoggerList*, const bool&);
+  
+  // Row subsampling (stochastic gradient boosting). The pseudo residuals
+  // and the base-learners are computed on a new subsample in every 
+  // iteration. The first elements of the permutation are the subsample:
+  double row_fraction = 1;
+  std::mt19937 row_generator;
+  std::vector<unsigned int> row_permutation;
+  
+  arma::uvec drawRows ();
+  
+  // Newton steps, the base-learners are fitted with the hessian as weights:
+  bool use_newton_steps = false;
+  
+  // Number of iterations between two computations of the risk of all rows:
+  unsigned int risk_every = 1;
+  
+  // Accelerated training (Nesterov's momentum). The update of the prediction
+  // of the last iteration and the momentum sequence are kept to continue the
+  // training:
+  bool use_acceleration = false;
+  arma::vec momentum_update;
+  double momentum_lambda = 0;
+  
+  // Models restored from a file own all of their components (loss, factories,
+  // and targets) and can just be used for prediction:
+  bool model_is_loaded = false;
+  std::vector<data::Data*> loaded_data_targets;
+  std::map<std::string, unsigned int> loaded_selection_counts;
+  
+  void loadModel (const std::string&);
+  void deleteLoadedComponents ();
+  void checkTrainable () const;
+  
+  // Loaded models don't contain the parameter of every iteration:
+  void checkTrace () const;
+  
+  // Periodic checkpoints of the initial training. The checkpoint is 
+  // serialized into a buffer and written by a background thread to not stall
+  // the training. The trace is serialized incrementally:
+  std::string checkpoint_file;
+  unsigned int checkpoint_every_iterations = 0;
+  double checkpoint_every_seconds = 0;
+  unsigned int checkpoint_last_iteration = 0;
+  std::chrono::steady_clock::time_point checkpoint_last_time;
+  std::string checkpoint_trace;
+  unsigned int checkpoint_trace_size = 0;
+  std::thread checkpoint_thread;
+  std::atomic<bool> checkpoint_in_progress {false};
+  std::string checkpoint_error;
+  
+  bool checkpointIsDue (const unsigned int&) const;
+  void writeCheckpoint (const unsigned int&, const arma::vec&, loggerlist::LoggerList*);
+  void joinCheckpoint ();
+  void reportCheckpointError ();
+  
 public:
   
   Compboost ();
@@ -119,8 +233,12 @@ public:
   Compboost (const arma::vec&, const double&, const bool&, optimizer::Optimizer*, loss::Loss*, 
     loggerlist::LoggerList*, blearnerlist::BaselearnerFactoryList);
   
-  // Basic train function used by trainCompbost and continueTraining:
-  void train (const unsigned int&, const arma::vec&, loggerlist::LoggerList*);
+  // Restore a model written by saveModel:
+  Compboost (const std::string&);
+  
+  // Basic train function used by trainCompbost and continueTraining. The 
+  // last argument is the first iteration (larger than one if resumed):
+  void train (const unsigned int&, const arma::vec&, loggerlist::LoggerList*, const unsigned int&);
   
   // Initial training:
   void trainCompboost (const unsigned int&);
@@ -128,10 +246,27 @@ public:
   // Retraining after initial training:
   void continueTraining (loggerlist::LoggerList*, const unsigned int&);
   
+  // Write checkpoints while training and resume the initial training:
+  void setCheckpoint (const std::string&, const unsigned int&, const double&);
+  void trainFromCheckpoint (const std::string&, const unsigned int&);
+  
+  // Same as above but in a background thread (just C++ pieces are allowed):
+  void trainCompboostAsync ();
+  void continueTrainingAsync (loggerlist::LoggerList*);
+  
+  // Control and monitor the asynchronous training:
+  bool isTrainingRunning () const;
+  bool isTrainingPaused () const;
+  void pauseTraining (const bool&);
+  void cancelTraining ();
+  void joinTraining ();
+  std::shared_ptr<const TrainingSnapshot> getTrainingSnapshot () const;
+  
   arma::vec getPrediction (const bool&) const;
   
   std::map<std::string, arma::mat> getParameter () const;
   std::vector<std::string> getSelectedBaselearner () const;
+  std::map<std::string, unsigned int> getSelectionCounts () const;
   
   std::map<std::string, loggerlist::LoggerList*> getLoggerList () const;
   std::map<std::string, arma::mat> getParameterOfIteration (const unsigned int&) const;
@@ -143,12 +278,30 @@ public:
   arma::vec predictionOfIteration (std::map<std::string, data::Data*>, const unsigned int&, const bool&) const;
   
   void setToIteration (const unsigned int&);
+  
+  // Train every iteration on a random subsample of the rows:
+  void setRowSubsampling (const double&, const unsigned int&);
+  
+  // Accelerate the training by Nesterov's momentum:
+  void setAcceleration (const bool&);
+  
+  // Use the second derivative of the loss for Newton steps:
+  void setNewtonSteps (const bool&);
+  
+  // Compute the risk of all rows just every given number of iterations:
+  void setRiskEvery (const unsigned int&);
+  
+  // Use piecewise polynomials to predict univariate effects on new data:
+  void setPrecompiledPrediction (const bool&);
 
   double getOffset () const;
   std::vector<double> getRiskVector () const;
   
   void summarizeCompboost () const;
   
+  // Write the trained model into a binary file:
+  void saveModel (const std::string&) const;
+  
   // Destructor:
   ~Compboost ();
   
@@ -56,7 +56,8 @@ public:
   virtual ~DataWrapper () { delete obj; }
 
 protected:
-  data::Data* obj;
+  // Initialized to be safely deleted if the constructor of a child throws:
+  data::Data* obj = NULL;
 
 };
 
@@ -115,6 +116,30 @@ protected:
 //' \describe{
 //' \item{\code{getData()}}{method extract the \code{data.mat} from the data object.}
 //' \item{\code{getIdentifier()}}{method to extract the used name from the data object.}
+//' \item{\code{saveData(file.name)}}{method to store a target object which
+//'   was prepared by a factory (design matrix, knots, penalty matrix, etc.)
+//'   into a binary file.}
+//' \item{\code{loadData(file.name)}}{method to restore a target object from a
+//'   file written by \code{saveData()}. If the restored object is passed as
+//'   target to a factory with the same configuration and source data, the
+//'   factory skips the preparation (e.g. creating the spline basis).}
+//' \item{\code{setSinglePrecision(use.single.precision)}}{method to store the
+//'   design matrix of a target object as single precision (float) values.
+//'   This halves the memory of the design matrix, sums within the training
+//'   are still computed in double precision. It is just used by the spline
+//'   factory and must be called before the target is passed to the factory.}
+//' \item{\code{getDesignBytes()}}{method to get the number of bytes of the
+//'   values of the design matrix which is stored in memory (without the
+//'   indices of sparse matrices).}
+//' \item{\code{setBinning(n.bins)}}{method to quantize the feature of a
+//'   target object into \code{n.bins} equally sized bins (at most 65536).
+//'   The target then stores the bin of each observation and the design
+//'   matrix of the bins instead of the full design matrix. The training just
+//'   sums the pseudo residuals per bin. Each bin is represented by the mean
+//'   of its values, hence the approximation error is controlled by the
+//'   number of bins. Binning is supported by the spline and the polynomial
+//'   factory (with one feature) and must be set before the target is passed
+//'   to the factory. Binned targets can't be saved.}
 //' }
 //' @examples
 //' # Sample data:
@@ -172,6 +197,207 @@ public:
   {
     return obj->getDataIdentifier();
   }
+  void saveData (std::string file_name) const
+  {
+    obj->saveData(file_name);
+  }
+  void loadData (std::string file_name)
+  {
+    obj->loadData(file_name);
+  }
+  void setSinglePrecision (bool use_single_precision)
+  {
+    obj->setSinglePrecision(use_single_precision);
+  }
+  unsigned int getDesignBytes () const
+  {
+    return obj->getDesignBytes();
+  }
+  void setBinning (unsigned int n_bins)
+  {
+    obj->setBinning(n_bins);
+  }
+};
+
+//' Data class to map a binary file into memory
+//'
+//' \code{MappedData} creates a source data object which reads one column of
+//' a binary file. The file is mapped into memory, hence the data is not
+//' loaded into \code{R} and the file can be larger than the available RAM.
+//'
+//' @format \code{\link{S4}} object.
+//' @name MappedData
+//'
+//' @section Usage:
+//' \preformatted{
+//' MappedData$new(file.name, n.rows, column, data.identifier)
+//' }
+//'
+//' @section Arguments:
+//' \describe{
+//' \item{\code{file.name} [\code{character(1)}]}{
+//'   Path to the binary file. The file contains the values of a numeric
+//'   matrix as 8 byte doubles in column-major order, e.g. written by
+//'   \code{writeBin(as.vector(X), file.name)}.
+//' }
+//' \item{\code{n.rows} [\code{integer(1)}]}{
+//'   Number of rows of the stored matrix. The number of columns is
+//'   calculated from the file size.
+//' }
+//' \item{\code{column} [\code{integer(1)}]}{
+//'   Column of the stored matrix which is used as source data (starting at 1).
+//' }
+//' \item{\code{data.identifier} [\code{character(1)}]}{
+//'   The name for the data. Note that it is important to have the same data
+//'   names for train and evaluation data.
+//' }
+//' }
+//'
+//' @section Details:
+//'   The object can just be used as source data. Factories build their target
+//'   data (e.g. the spline basis) from the mapped column, the operating system
+//'   just loads the pages which are accessed. Mapping files is not supported
+//'   on Windows.
+//'
+//'   This class is a wrapper around the pure \code{C++} implementation. To see
+//'   the functionality of the \code{C++} class visit
+//'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classdata_1_1_mapped_data.html}.
+//'
+//' @section Fields:
+//'   This class doesn't contain public fields.
+//'
+//' @section Methods:
+//' \describe{
+//' \item{\code{getData()}}{method to read the mapped column into a matrix.}
+//' \item{\code{getIdentifier()}}{method to extract the used name from the data object.}
+//' \item{\code{getFileName()}}{method to extract the path of the mapped file.}
+//' }
+//' @examples
+//' \dontrun{
+//' # Write sample data into a binary file:
+//' X = matrix(rnorm(20), ncol = 2)
+//' file.name = tempfile()
+//' writeBin(as.vector(X), file.name)
+//'
+//' # Map the second column:
+//' data.obj = MappedData$new(file.name, 10, 2, "my.data.name")
+//'
+//' # Get data and identifier:
+//' data.obj$getData()
+//' data.obj$getIdentifier()
+//' }
+//' @export MappedData
+class MappedDataWrapper : public DataWrapper
+{
+public:
+
+  MappedDataWrapper (std::string file_name, unsigned int n_rows, unsigned int column,
+    std::string data_identifier)
+  {
+    if (column < 1) {
+      Rcpp::stop("The column must be a positive integer.");
+    }
+    obj = new data::MappedData (file_name, n_rows, column - 1, data_identifier);
+  }
+  arma::mat getData () const
+  {
+    return obj->getData();
+  }
+  std::string getIdentifier () const
+  {
+    return obj->getDataIdentifier();
+  }
+  std::string getFileName () const
+  {
+    return static_cast<data::MappedData*>(obj)->getFileName();
+  }
+};
+
+//' Data class to store a spline basis in chunks on disk
+//'
+//' \code{ChunkedData} creates a target data object which stores the design
+//' matrix of a spline base-learner in row chunks within a binary file. This
+//' allows to train on data with a design matrix larger than the available RAM.
+//'
+//' @format \code{\link{S4}} object.
+//' @name ChunkedData
+//'
+//' @section Usage:
+//' \preformatted{
+//' ChunkedData$new(file.name, chunk.size)
+//' }
+//'
+//' @section Arguments:
+//' \describe{
+//' \item{\code{file.name} [\code{character(1)}]}{
+//'   Path of the file which is used to store the chunks. The file is removed
+//'   when the object is deleted.
+//' }
+//' \item{\code{chunk.size} [\code{integer(1)}]}{
+//'   Number of rows stored within one chunk.
+//' }
+//' }
+//'
+//' @section Details:
+//'   The object can just be used as target of the spline factory
+//'   (\code{BaselearnerPSpline}). The factory writes the basis chunk by
+//'   chunk, hence the full basis is never in memory. Each row of the basis
+//'   is stored as the index of the first non zero column and the
+//'   \code{degree + 1} non zero values. Training and predicting stream the
+//'   chunks from the file while the next chunk is read in the background.
+//'   Therefore, just two chunks are held in memory at the same time. The
+//'   response, prediction, and pseudo residuals are still kept in memory.
+//'
+//'   This class is a wrapper around the pure \code{C++} implementation. To see
+//'   the functionality of the \code{C++} class visit
+//'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classdata_1_1_chunked_data.html}.
+//'
+//' @section Fields:
+//'   This class doesn't contain public fields.
+//'
+//' @section Methods:
+//' \describe{
+//' \item{\code{getData()}}{method to read all chunks into a dense matrix.
+//'   This is just meant for small data.}
+//' \item{\code{getIdentifier()}}{method to extract the used name from the data object.}
+//' \item{\code{getFileName()}}{method to extract the path of the file containing the chunks.}
+//' }
+//' @examples
+//' # Sample data:
+//' data.mat = cbind(runif(100))
+//'
+//' # Create source and chunked target object:
+//' data.source = InMemoryData$new(data.mat, "my.data.name")
+//' data.target = ChunkedData$new(tempfile(), 20)
+//'
+//' # Write the spline basis into the chunks:
+//' spline.factory = BaselearnerPSpline$new(data.source, data.target, 3, 5, 2, 2)
+//'
+//' # Get data and identifier:
+//' data.target$getData()
+//' data.target$getIdentifier()
+//'
+//' @export ChunkedData
+class ChunkedDataWrapper : public DataWrapper
+{
+public:
+
+  ChunkedDataWrapper (std::string file_name, unsigned int chunk_size)
+  {
+    obj = new data::ChunkedData (file_name, chunk_size);
+  }
+  arma::mat getData () const
+  {
+    return obj->getData();
+  }
+  std::string getIdentifier () const
+  {
+    return obj->getDataIdentifier();
+  }
+  std::string getFileName () const
+  {
+    return static_cast<data::ChunkedData*>(obj)->getFileName();
+  }
 };
 
 
@@ -194,6 +420,31 @@ RCPP_MODULE (data_module)
 
     .method("getData",       &InMemoryDataWrapper::getData, "Get data")
     .method("getIdentifier", &InMemoryDataWrapper::getIdentifier, "Get the data identifier")
+    .method("saveData",      &InMemoryDataWrapper::saveData, "Store prepared target data into a file")
+    .method("loadData",      &InMemoryDataWrapper::loadData, "Restore prepared target data from a file")
+    .method("setSinglePrecision", &InMemoryDataWrapper::setSinglePrecision, "Store the design matrix of a target in single precision")
+    .method("getDesignBytes",     &InMemoryDataWrapper::getDesignBytes, "Get the bytes of the values of the stored design matrix")
+    .method("setBinning",         &InMemoryDataWrapper::setBinning, "Quantize the feature of a target into bins")
+  ;
+
+  class_<MappedDataWrapper> ("MappedData")
+    .derives<DataWrapper> ("Data")
+
+    .constructor<std::string, unsigned int, unsigned int, std::string> ()
+
+    .method("getData",       &MappedDataWrapper::getData, "Get data")
+    .method("getIdentifier", &MappedDataWrapper::getIdentifier, "Get the data identifier")
+    .method("getFileName",   &MappedDataWrapper::getFileName, "Get the name of the mapped file")
+  ;
+
+  class_<ChunkedDataWrapper> ("ChunkedData")
+    .derives<DataWrapper> ("Data")
+
+    .constructor<std::string, unsigned int> ()
+
+    .method("getData",       &ChunkedDataWrapper::getData, "Get data")
+    .method("getIdentifier", &ChunkedDataWrapper::getIdentifier, "Get the data identifier")
+    .method("getFileName",   &ChunkedDataWrapper::getFileName, "Get the name of the file containing the chunks")
   ;
 }
 
@@ -386,9 +637,11 @@ public:
 //'   Number of \strong{inner knots}. To prevent weird behavior on the edges
 //'   the inner knots are expanded by \eqn{\mathrm{degree} - 1} additional knots.
 //' }
-//' \item{\code{penalty} [\code{numeric(1)}]}{
+//' \item{\code{penalty} [\code{numeric()}]}{
 //'   Positive numeric value to specify the penalty parameter. Setting the
-//'   penalty to 0 ordinary B-splines are used for the fitting.
+//'   penalty to 0 ordinary B-splines are used for the fitting. If a vector
+//'   of penalties is given, the penalty is chosen in every iteration (see
+//'   details).
 //' }
 //' \item{\code{differences} [\code{integer(1)}]}{
 //'   The number of differences which are penalized. A higher value leads to
@@ -401,6 +654,22 @@ public:
 //'   The spline bases are created for this single feature. Multidimensional
 //'   splines are not supported at the moment.
 //'
+//'   Using a vector of penalties is cheaper than registering one factory per
+//'   penalty. The basis and its cross product are shared and a
+//'   Demmler-Reinsch decomposition is computed once. In every iteration, the
+//'   base-learner computes the solutions of all penalties from the same
+//'   \eqn{X^T r} and uses the one with the smallest generalized cross
+//'   validation criterion (the training error always prefers the smallest
+//'   penalty).
+//'
+//'   Instead of the penalty, the degrees of freedom can be specified by
+//'   \code{setDegreesOfFreedom()}. The penalty is then computed from the
+//'   Demmler-Reinsch orthogonalization of the cross product of the basis
+//'   and the penalty matrix. This is done once when the model is created,
+//'   and the factories are handled in parallel. Base-learners with equal
+//'   degrees of freedom are equally flexible, which makes the selection
+//'   between features fairer.
+//'
 //'   This class is a wrapper around the pure \code{C++} implementation. To see
 //'   the functionality of the \code{C++} class visit
 //'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classblearnerfactory_1_1_p_spline_blearner_factory.html}.
@@ -415,6 +684,11 @@ public:
 //' \item{\code{transformData(X)}}{Transform a data matrix as defined within the
 //'   factory. The argument has to be a matrix with one column.}
 //' \item{\code{summarizeFactory()}}{Summarize the base-learner factory object.}
+//' \item{\code{setDegreesOfFreedom(df)}}{Compute the penalty such that the
+//'   base-learner has \code{df} degrees of freedom. The degrees of freedom
+//'   must be larger than \code{differences} and can't exceed the number of
+//'   basis functions \code{n_knots + degree + 1}.}
+//' \item{\code{getPenalty()}}{Get the penalty used by the base-learner.}
 //' }
 //' @examples
 //' # Sample data:
@@ -438,34 +712,58 @@ public:
 //' # Transform data manually:
 //' spline.factory$transformData(data.mat)
 //'
+//' # Choose the penalty in every iteration:
+//' data.target.multi = InMemoryData$new()
+//' spline.factory.multi = BaselearnerPSpline$new(data.source, data.target.multi,
+//'   degree = 3, n_knots = 4, penalty = c(1, 10, 100), differences = 2)
+//'
+//' # Specify the degrees of freedom:
+//' data.target.df = InMemoryData$new()
+//' spline.factory.df = BaselearnerPSpline$new(data.source, data.target.df,
+//'   degree = 3, n_knots = 4, penalty = 0, differences = 2)
+//' spline.factory.df$setDegreesOfFreedom(4)
+//' spline.factory.df$getPenalty()
+//'
 //' @export BaselearnerPSpline
 class BaselearnerPSplineFactoryWrapper : public BaselearnerFactoryWrapper
 {
 private:
   const unsigned int degree;
 
+  // One penalty or a vector of penalties to choose from:
+  blearnerfactory::BaselearnerFactory* createFactory (const std::string& blearner_type,
+    DataWrapper& data_source, DataWrapper& data_target, const unsigned int& n_knots, 
+    const arma::vec& penalty, const unsigned int& differences) const
+  {
+    if (penalty.n_elem == 0 || arma::any(penalty < 0)) {
+      Rcpp::stop("The penalty must be a non empty vector of non negative values.");
+    }
+    if (penalty.n_elem == 1) {
+      return new blearnerfactory::BaselearnerPSplineFactory(blearner_type, data_source.getDataObj(),
+        data_target.getDataObj(), degree, n_knots, penalty[0], differences, TRUE);
+    }
+    return new blearnerfactory::BaselearnerPSplineFactory(blearner_type, data_source.getDataObj(),
+      data_target.getDataObj(), degree, n_knots, penalty, differences, TRUE);
+  }
+
 public:
 
   BaselearnerPSplineFactoryWrapper (DataWrapper& data_source, DataWrapper& data_target,
-    const unsigned int& degree, const unsigned int& n_knots, const double& penalty,
+    const unsigned int& degree, const unsigned int& n_knots, const arma::vec& penalty,
     const unsigned int& differences)
     : degree ( degree )
   {
     std::string blearner_type_temp = "spline_degree_" + std::to_string(degree);
     
-    obj = new blearnerfactory::BaselearnerPSplineFactory(blearner_type_temp, data_source.getDataObj(),
-       data_target.getDataObj(), degree, n_knots, penalty, differences, TRUE);      
-
+    obj = createFactory(blearner_type_temp, data_source, data_target, n_knots, penalty, differences);
   }
 
   BaselearnerPSplineFactoryWrapper (DataWrapper& data_source, DataWrapper& data_target,
     const std::string& blearner_type, const unsigned int& degree, 
-    const unsigned int& n_knots, const double& penalty, const unsigned int& differences)
+    const unsigned int& n_knots, const arma::vec& penalty, const unsigned int& differences)
     : degree ( degree )
   {
-    obj = new blearnerfactory::BaselearnerPSplineFactory(blearner_type, data_source.getDataObj(),
-      data_target.getDataObj(), degree, n_knots, penalty, differences, TRUE);
-
+    obj = createFactory(blearner_type, data_source, data_target, n_knots, penalty, differences);
   }
 
   arma::mat getData () { return obj->getData(); }
@@ -477,6 +775,16 @@ public:
     return obj->instantiateData(newdata);
   }
 
+  void setDegreesOfFreedom (const double& df)
+  {
+    static_cast<blearnerfactory::BaselearnerPSplineFactory*>(obj)->setDegreesOfFreedom(df);
+  }
+
+  double getPenalty ()
+  {
+    return static_cast<blearnerfactory::BaselearnerPSplineFactory*>(obj)->getPenalty();
+  }
+
   void summarizeFactory ()
   {
     Rcpp::Rcout << "Spline factory of degree" << " " << std::to_string(degree) << std::endl;
@@ -793,11 +1101,13 @@ RCPP_MODULE (baselearner_factory_module)
 
   class_<BaselearnerPSplineFactoryWrapper> ("BaselearnerPSpline")
     .derives<BaselearnerFactoryWrapper> ("Baselearner")
-    .constructor<DataWrapper&, DataWrapper&, unsigned int, unsigned int, double, unsigned int> ()
-    .constructor<DataWrapper&, DataWrapper&, std::string, unsigned int, unsigned int, double, unsigned int> ()
+    .constructor<DataWrapper&, DataWrapper&, unsigned int, unsigned int, arma::vec, unsigned int> ()
+    .constructor<DataWrapper&, DataWrapper&, std::string, unsigned int, unsigned int, arma::vec, unsigned int> ()
     .method("getData",          &BaselearnerPSplineFactoryWrapper::getData, "Get design matrix")
     .method("transformData",    &BaselearnerPSplineFactoryWrapper::transformData, "Compute spline basis for new data")
     .method("summarizeFactory", &BaselearnerPSplineFactoryWrapper::summarizeFactory, "Summarize Factory")
+    .method("setDegreesOfFreedom", &BaselearnerPSplineFactoryWrapper::setDegreesOfFreedom, "Compute the penalty from the degrees of freedom")
+    .method("getPenalty",       &BaselearnerPSplineFactoryWrapper::getPenalty, "Get the penalty")
   ;
 
   class_<BaselearnerCustomFactoryWrapper> ("BaselearnerCustom")
@@ -1349,7 +1659,8 @@ public:
   virtual ~LoggerWrapper () { delete obj; }
 
 protected:
-  logger::Logger* obj;
+  // Initialized to be safely deleted if the constructor of a child throws:
+  logger::Logger* obj = NULL;
   std::string logger_id;
 };
 
@@ -1437,6 +1748,8 @@ public:
 //' @section Usage:
 //' \preformatted{
 //' LoggerInbagRisk$new(use_as_stopper, used_loss, eps_for_break)
+//' LoggerInbagRisk$new(use_as_stopper, used_loss, eps_for_break, log_every,
+//'   row_fraction)
 //' }
 //'
 //' @section Arguments:
@@ -1453,6 +1766,15 @@ public:
 //'   improvement of the logged inbag risk falls above this boundary the stopper
 //'   returns \code{TRUE}.
 //' }
+//' \item{\code{log_every} [\code{integer(1)}]}{
+//'   Optional, the risk is just evaluated every \code{log_every} iteration.
+//'   The other iterations are logged as \code{NaN}. Default is 1.
+//' }
+//' \item{\code{row_fraction} [\code{numeric(1)}]}{
+//'   Optional, fraction of rows in \eqn{(0, 1]} which are used to evaluate the
+//'   risk. The rows are drawn once (use \code{set.seed()} for
+//'   reproducibility). Default is 1.
+//' }
 //' }
 //'
 //' @section Details:
@@ -1471,6 +1793,11 @@ public:
 //'     If \eqn{m=0} than \eqn{\hat{f}} is just the offset.
 //'
 //'   \item
+//'     If the risk is just evaluated every \eqn{s}-th iteration, the relative
+//'     improvement between the last two evaluations is divided by \eqn{s}
+//'     before it is compared with \code{eps_for_break}.
+//'
+//'   \item
 //'     The implementation to calculate \eqn{\mathcal{R}_\mathrm{emp}^{[m]}} is
 //'     done in two steps:
 //'       \enumerate{
@@ -1497,6 +1824,11 @@ public:
 //'
 //' @section Methods:
 //' \describe{
+//'   \item{\code{setPlateauWindow(plateau_window)}}{Compare the risk with the
+//'     risk \code{plateau_window} evaluations ago instead of the last one. The
+//'     average relative improvement over this moving window is compared with
+//'     \code{eps_for_break}, hence single iterations with (almost) no
+//'     improvement do not stop the algorithm. Default is 1.}
 //'   \item{\code{summarizeLogger()}}{Summarize the logger object.}
 //' }
 //' @examples
@@ -1526,6 +1858,21 @@ public:
     logger_id = "inbag.risk";
   }
 
+  LoggerInbagRiskWrapper (bool use_as_stopper, LossWrapper& used_loss, double eps_for_break,
+    unsigned int log_every, double row_fraction)
+    : eps_for_break ( eps_for_break ),
+      use_as_stopper ( use_as_stopper)
+  {
+    obj = new logger::LoggerInbagRisk (use_as_stopper, used_loss.getLoss(), eps_for_break,
+      log_every, row_fraction);
+    logger_id = "inbag.risk";
+  }
+
+  void setPlateauWindow (const unsigned int& plateau_window)
+  {
+    static_cast<logger::LoggerInbagRisk*>(obj)->setPlateauWindow(plateau_window);
+  }
+
   void summarizeLogger ()
   {
     Rcpp::Rcout << "Inbag risk logger:" << std::endl;
@@ -1549,6 +1896,8 @@ public:
 //' \preformatted{
 //' LoggerOobRisk$new(use_as_stopper, used_loss, eps_for_break, oob_data,
 //'   oob_response)
+//' LoggerOobRisk$new(use_as_stopper, used_loss, eps_for_break, oob_data,
+//'   oob_response, log_every, row_fraction)
 //' }
 //'
 //' @section Arguments:
@@ -1575,6 +1924,15 @@ public:
 //'   Vector which contains the response for the out of bag data given within
 //'   the \code{list}.
 //' }
+//' \item{\code{log_every} [\code{integer(1)}]}{
+//'   Optional, the risk is just evaluated every \code{log_every} iteration.
+//'   The other iterations are logged as \code{NaN}. Default is 1.
+//' }
+//' \item{\code{row_fraction} [\code{numeric(1)}]}{
+//'   Optional, fraction of rows in \eqn{(0, 1]} which are used to evaluate the
+//'   risk. The rows are drawn once (use \code{set.seed()} for
+//'   reproducibility). Default is 1.
+//' }
 //' }
 //'
 //' @section Details:
@@ -1595,6 +1953,11 @@ public:
 //'     If \eqn{m=0} than \eqn{\hat{f}} is just the offset.
 //'
 //'   \item
+//'     If the risk is just evaluated every \eqn{s}-th iteration, the relative
+//'     improvement between the last two evaluations is divided by \eqn{s}
+//'     before it is compared with \code{eps_for_break}.
+//'
+//'   \item
 //'     The implementation to calculate \eqn{\mathcal{R}_\mathrm{emp}^{[m]}} is
 //'     done in two steps:
 //'       \enumerate{
@@ -1623,6 +1986,12 @@ public:
 //'
 //' @section Methods:
 //' \describe{
+//' \item{\code{setPlateauWindow(plateau_window)}}{Compare the risk with the
+//'   risk \code{plateau_window} evaluations ago instead of the last one. The
+//'   average relative improvement over this moving window is compared with
+//'   \code{eps_for_break}. Together with \code{log_every} the out of bag risk
+//'   is just evaluated every few iterations while a plateau is still
+//'   detected. Default is 1.}
 //' \item{\code{summarizeLogger()}}{Summarize the logger object.}
 //' }
 //' @examples
@@ -1684,6 +2053,29 @@ public:
     logger_id = "oob.risk";
   }
 
+  LoggerOobRiskWrapper (bool use_as_stopper, LossWrapper& used_loss, double eps_for_break,
+    Rcpp::List oob_data, arma::vec oob_response, unsigned int log_every, double row_fraction)
+    : eps_for_break ( eps_for_break ),
+      use_as_stopper ( use_as_stopper)
+  {
+    std::map<std::string, data::Data*> oob_data_map;
+
+    // See the constructor above why the data wrapper is accessed as pointer:
+    for (unsigned int i = 0; i < oob_data.size(); i++) {
+      DataWrapper* temp = oob_data[i];
+      oob_data_map[ temp->getDataObj()->getDataIdentifier() ] = temp->getDataObj();
+    }
+
+    obj = new logger::LoggerOobRisk (use_as_stopper, used_loss.getLoss(), eps_for_break,
+      oob_data_map, oob_response, log_every, row_fraction);
+    logger_id = "oob.risk";
+  }
+
+  void setPlateauWindow (const unsigned int& plateau_window)
+  {
+    static_cast<logger::LoggerOobRisk*>(obj)->setPlateauWindow(plateau_window);
+  }
+
   void summarizeLogger ()
   {
     Rcpp::Rcout << "Out of bag risk logger:" << std::endl;
@@ -1739,6 +2131,11 @@ public:
 //'
 //' @section Methods:
 //' \describe{
+//' \item{\code{setLookahead(use_lookahead)}}{If \code{TRUE}, the time of the
+//'   next iteration is projected by the average time per iteration and the
+//'   algorithm stops if the projection exceeds \code{max_time}. Hence, the
+//'   training stops within the time budget instead of after it. Default is
+//'   \code{FALSE}.}
 //' \item{\code{summarizeLogger()}}{Summarize the logger object.}
 //' }
 //' @examples
@@ -1768,6 +2165,11 @@ public:
     logger_id = "time." + time_unit;
   }
 
+  void setLookahead (const bool& use_lookahead)
+  {
+    static_cast<logger::LoggerTime*>(obj)->setLookahead(use_lookahead);
+  }
+
   void summarizeLogger ()
   {
     Rcpp::Rcout << "Time logger:" << std::endl;
@@ -1914,18 +2316,23 @@ RCPP_MODULE(logger_module)
   class_<LoggerInbagRiskWrapper> ("LoggerInbagRisk")
     .derives<LoggerWrapper> ("Logger")
     .constructor<bool, LossWrapper&, double> ()
+    .constructor<bool, LossWrapper&, double, unsigned int, double> ()
+    .method("setPlateauWindow", &LoggerInbagRiskWrapper::setPlateauWindow, "Set the number of evaluations used to detect a plateau")
     .method("summarizeLogger", &LoggerInbagRiskWrapper::summarizeLogger, "Summarize logger")
   ;
 
   class_<LoggerOobRiskWrapper> ("LoggerOobRisk")
     .derives<LoggerWrapper> ("Logger")
     .constructor<bool, LossWrapper&, double, Rcpp::List, arma::vec> ()
+    .constructor<bool, LossWrapper&, double, Rcpp::List, arma::vec, unsigned int, double> ()
+    .method("setPlateauWindow", &LoggerOobRiskWrapper::setPlateauWindow, "Set the number of evaluations used to detect a plateau")
     .method("summarizeLogger", &LoggerOobRiskWrapper::summarizeLogger, "Summarize logger")
   ;
 
   class_<LoggerTimeWrapper> ("LoggerTime")
     .derives<LoggerWrapper> ("Logger")
     .constructor<bool, unsigned int, std::string> ()
+    .method("setLookahead", &LoggerTimeWrapper::setLookahead, "Stop if the next iteration is expected to exceed the time budget")
     .method("summarizeLogger", &LoggerTimeWrapper::summarizeLogger, "Summarize logger")
   ;
 
@@ -1953,7 +2360,8 @@ public:
   virtual ~OptimizerWrapper () { delete obj; }
 
 protected:
-  optimizer::Optimizer* obj;
+  // Initialized to be safely deleted if the constructor of a child throws:
+  optimizer::Optimizer* obj = NULL;
 };
 
 //' Greedy Optimizer
@@ -2003,6 +2411,369 @@ public:
   // }
 };
 
+//' Greedy optimizer with line search
+//'
+//' This class defines a new object for the greedy optimizer with a line
+//' search. The base-learner is selected as by
+//' \code{OptimizerCoordinateDescent}, but the step is the minimizer of the
+//' empirical risk along the prediction of the selected base-learner.
+//'
+//' @format \code{\link{S4}} object.
+//' @name OptimizerCoordinateDescentLineSearch
+//'
+//' @section Usage:
+//' \preformatted{
+//' OptimizerCoordinateDescentLineSearch$new()
+//' }
+//'
+//' @section Details:
+//'   The base-learner is fitted to the pseudo residuals by least squares,
+//'   which is not the best step for a loss other than the quadratic one
+//'   (e.g. \code{LossBinomial} or \code{LossAbsolute}). The optimizer searches
+//'   the step size with the smallest empirical risk on all rows by Newton's
+//'   method if the loss has a second derivative (\code{LossQuadratic} or
+//'   \code{LossBinomial}) and by a golden section search otherwise or if
+//'   Newton's method fails. The learning rate is multiplied with this step size and
+//'   the step size is folded into the parameter of the base-learner. Hence,
+//'   fewer iterations are required. Custom base-learners are always updated
+//'   with a step size of one.
+//'
+//'   This class is a wrapper around the pure \code{C++} implementation. To see
+//'   the functionality of the \code{C++} class visit
+//'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classoptimizer_1_1_greedy_optimizer.html}.
+//'
+//' @section Methods:
+//' \describe{
+//' \item{\code{getStepSize()}}{Get the step size of every iteration.}
+//' }
+//'
+//' @examples
+//'
+//' # Define optimizer:
+//' optimizer = OptimizerCoordinateDescentLineSearch$new()
+//'
+//' @export OptimizerCoordinateDescentLineSearch
+class OptimizerCoordinateDescentLineSearch : public OptimizerWrapper
+{
+public:
+  OptimizerCoordinateDescentLineSearch () { obj = new optimizer::OptimizerCoordinateDescentLineSearch(); }
+
+  std::vector<double> getStepSize ()
+  {
+    return static_cast<optimizer::OptimizerCoordinateDescentLineSearch*>(obj)->getStepSizes();
+  }
+};
+
+//' Random coordinate descent
+//'
+//' This class defines a new object for the random coordinate descent. In
+//' every iteration, just a random fraction of the base-learners is trained
+//' and the one with the smallest SSE is selected.
+//'
+//' @format \code{\link{S4}} object.
+//' @name OptimizerRandomCoordinateDescent
+//'
+//' @section Usage:
+//' \preformatted{
+//' OptimizerRandomCoordinateDescent$new(fraction, window, seed)
+//' }
+//'
+//' @section Arguments:
+//' \describe{
+//' \item{\code{fraction} [\code{numeric(1)}]}{
+//'   Fraction of base-learners which are evaluated in every iteration. The
+//'   number of evaluated base-learners is rounded up.
+//' }
+//' \item{\code{window} [\code{integer(1)}]}{
+//'   Every base-learner is evaluated at least once within \code{window}
+//'   iterations. Setting \code{window = 0} draws the base-learners without
+//'   this guarantee.
+//' }
+//' \item{\code{seed} [\code{integer(1)}]}{
+//'   Seed of the random number generator. The same seed yields the same
+//'   sequence of evaluated base-learners.
+//' }
+//' }
+//'
+//' @section Details:
+//'   The time per iteration decreases proportional to \code{fraction}. Since
+//'   the best base-learner is not always evaluated, more iterations may be
+//'   required to reach the same risk. The random numbers are not drawn from
+//'   the \code{R} random number generator, hence \code{set.seed()} has no
+//'   effect.
+//'
+//'   This class is a wrapper around the pure \code{C++} implementation. To see
+//'   the functionality of the \code{C++} class visit
+//'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classoptimizer_1_1_greedy_optimizer.html}.
+//'
+//' @examples
+//'
+//' # Define optimizer which evaluates 10 \% of the base-learners:
+//' optimizer = OptimizerRandomCoordinateDescent$new(0.1, 20, 31415)
+//'
+//' @export OptimizerRandomCoordinateDescent
+class OptimizerRandomCoordinateDescent : public OptimizerWrapper
+{
+private:
+  const double fraction;
+  const unsigned int window;
+
+public:
+  OptimizerRandomCoordinateDescent (const double& fraction, const unsigned int& window, 
+    const unsigned int& seed)
+    : fraction ( fraction ),
+      window ( window )
+  { 
+    obj = new optimizer::OptimizerRandomCoordinateDescent(fraction, window, seed); 
+  }
+
+  double getFraction () { return fraction; }
+  unsigned int getWindow () { return window; }
+};
+
+//' Lazy coordinate descent
+//'
+//' This class defines a new object for the lazy coordinate descent. The
+//' optimizer selects the same base-learner as the greedy optimizer
+//' (\code{OptimizerCoordinateDescent}) but skips base-learners which can't
+//' be the best one.
+//'
+//' @format \code{\link{S4}} object.
+//' @name OptimizerLazyCoordinateDescent
+//'
+//' @section Usage:
+//' \preformatted{
+//' OptimizerLazyCoordinateDescent$new()
+//' }
+//'
+//' @section Details:
+//'   The reduction of the SSE of a polynomial or spline base-learner
+//'   (with one penalty) can't grow faster than the change of the pseudo
+//'   residuals since its last evaluation. The optimizer keeps this upper
+//'   bound for every base-learner and just trains the base-learners whose
+//'   bound can beat the best trained one. The selected base-learner is
+//'   still the exact minimizer of the SSE. Custom base-learners and splines
+//'   with multiple penalties are always trained. If the rows are subsampled,
+//'   all base-learners are trained.
+//'
+//'   This class is a wrapper around the pure \code{C++} implementation. To see
+//'   the functionality of the \code{C++} class visit
+//'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classoptimizer_1_1_greedy_optimizer.html}.
+//'
+//' @section Methods:
+//' \describe{
+//' \item{\code{getPruningStatistics()}}{Get a \code{data.frame} with the number
+//'   of trained (\code{evaluated}) and skipped (\code{pruned}) base-learners
+//'   of every iteration.}
+//' }
+//'
+//' @examples
+//'
+//' # Define optimizer:
+//' optimizer = OptimizerLazyCoordinateDescent$new()
+//'
+//' @export OptimizerLazyCoordinateDescent
+class OptimizerLazyCoordinateDescent : public OptimizerWrapper
+{
+public:
+  OptimizerLazyCoordinateDescent () { obj = new optimizer::OptimizerLazyCoordinateDescent(); }
+
+  Rcpp::DataFrame getPruningStatistics ()
+  {
+    optimizer::OptimizerLazyCoordinateDescent* lazy_optimizer = static_cast<optimizer::OptimizerLazyCoordinateDescent*>(obj);
+    return Rcpp::DataFrame::create(
+      Rcpp::Named("evaluated") = lazy_optimizer->getNumberOfEvaluatedFactories(),
+      Rcpp::Named("pruned")    = lazy_optimizer->getNumberOfPrunedFactories()
+    );
+  }
+};
+
+//' Working set coordinate descent
+//'
+//' This class defines a new object for the coordinate descent on a working
+//' set. Just the best base-learners of the last full sweep over all
+//' base-learners are trained in every iteration.
+//'
+//' @format \code{\link{S4}} object.
+//' @name OptimizerWorkingSetCoordinateDescent
+//'
+//' @section Usage:
+//' \preformatted{
+//' OptimizerWorkingSetCoordinateDescent$new(n_working_set, refresh_iterations)
+//' }
+//'
+//' @section Arguments:
+//' \describe{
+//' \item{\code{n_working_set} [\code{integer(1)}]}{
+//'   Number of base-learners with the smallest SSE of the last full sweep
+//'   which are trained between two full sweeps.
+//' }
+//' \item{\code{refresh_iterations} [\code{integer(1)}]}{
+//'   Number of iterations after which all base-learners are trained again.
+//'   Setting \code{refresh_iterations = 1} is the greedy optimizer.
+//' }
+//' }
+//'
+//' @section Details:
+//'   The base-learners which explain the pseudo residuals well are often
+//'   selected in many consecutive iterations. Training just these
+//'   base-learners reduces the time per iteration to roughly
+//'   \code{n_working_set} base-learners. Since a base-learner outside of the
+//'   working set can become the best one, the selection is approximate
+//'   between two full sweeps.
+//'
+//'   This class is a wrapper around the pure \code{C++} implementation. To see
+//'   the functionality of the \code{C++} class visit
+//'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classoptimizer_1_1_greedy_optimizer.html}.
+//'
+//' @section Methods:
+//' \describe{
+//' \item{\code{getNumberOfWorkingSet()}}{Get the size of the working set.}
+//' \item{\code{getRefreshIterations()}}{Get the number of iterations between
+//'   two full sweeps.}
+//' \item{\code{getSelectionTrace()}}{Get a \code{data.frame} which indicates
+//'   for every iteration if the base-learner was selected by a full sweep
+//'   (\code{full.sweep}).}
+//' }
+//'
+//' @examples
+//'
+//' # Define optimizer which trains the best 5 base-learners and refreshes
+//' # them every 10 iterations:
+//' optimizer = OptimizerWorkingSetCoordinateDescent$new(5, 10)
+//'
+//' @export OptimizerWorkingSetCoordinateDescent
+class OptimizerWorkingSetCoordinateDescent : public OptimizerWrapper
+{
+private:
+  const unsigned int n_working_set;
+  const unsigned int refresh_iterations;
+
+public:
+  OptimizerWorkingSetCoordinateDescent (const unsigned int& n_working_set, const unsigned int& refresh_iterations)
+    : n_working_set ( n_working_set ),
+      refresh_iterations ( refresh_iterations )
+  {
+    obj = new optimizer::OptimizerWorkingSetCoordinateDescent(n_working_set, refresh_iterations);
+  }
+
+  unsigned int getNumberOfWorkingSet () { return n_working_set; }
+  unsigned int getRefreshIterations () { return refresh_iterations; }
+
+  Rcpp::DataFrame getSelectionTrace ()
+  {
+    optimizer::OptimizerWorkingSetCoordinateDescent* ws_optimizer = static_cast<optimizer::OptimizerWorkingSetCoordinateDescent*>(obj);
+    std::vector<bool> full_sweeps = ws_optimizer->getFullSweeps();
+    return Rcpp::DataFrame::create(
+      Rcpp::Named("iteration")  = Rcpp::seq_len(full_sweeps.size()),
+      Rcpp::Named("full.sweep") = Rcpp::wrap(full_sweeps)
+    );
+  }
+};
+
+//' Coordinate descent with cached cross products
+//'
+//' This class defines a new object for the greedy optimizer which keeps the
+//' cross products of every base-learner with the pseudo residuals and
+//' updates them instead of recomputing them in every iteration.
+//'
+//' @format \code{\link{S4}} object.
+//' @name OptimizerCachedCoordinateDescent
+//'
+//' @section Usage:
+//' \preformatted{
+//' OptimizerCachedCoordinateDescent$new()
+//' OptimizerCachedCoordinateDescent$new(n_cached)
+//' }
+//'
+//' @section Arguments:
+//' \describe{
+//' \item{\code{n_cached} [\code{integer(1)}]}{
+//'   Optional, number of selected base-learners whose cross products with
+//'   all other base-learners are cached. If more base-learners are selected,
+//'   the cross products of the least recently selected one are removed.
+//'   Default is 50.
+//' }
+//' }
+//'
+//' @section Details:
+//'   For the quadratic loss, the pseudo residuals are \eqn{r = y - f}. The
+//'   update of the prediction by the selected base-learner \eqn{s} with
+//'   learning rate \eqn{\nu} therefore changes the cross product of every
+//'   base-learner \eqn{j} by
+//'   \deqn{
+//'     X_j^T r \leftarrow X_j^T r - \nu X_j^T X_s \beta_s.
+//'   }
+//'   The cross products \eqn{X_j^T X_s} are computed once when \eqn{s} is
+//'   selected and are then cached. Hence, the base-learners are trained
+//'   without a sweep over the rows of the data and the selection within one
+//'   iteration doesn't depend on the number of observations. The selected
+//'   base-learners equal those of \code{OptimizerCoordinateDescent}.
+//'
+//'   The cross products are computed from scratch if they don't match the
+//'   pseudo residuals, e.g. for other losses or for accelerated training.
+//'   On a subsample of the
+//'   rows, with Newton steps, or with base-learners which don't provide their
+//'   design matrix (e.g. custom base-learners), the optimizer behaves like
+//'   \code{OptimizerCoordinateDescent}.
+//'
+//'   This class is a wrapper around the pure \code{C++} implementation. To see
+//'   the functionality of the \code{C++} class visit
+//'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classoptimizer_1_1_greedy_optimizer.html}.
+//'
+//' @section Methods:
+//' \describe{
+//' \item{\code{getNumberOfCached()}}{Get the maximal number of base-learners
+//'   whose cross products are cached.}
+//' \item{\code{getNumberOfCachedBaselearner()}}{Get the number of
+//'   base-learners whose cross products are cached at the moment.}
+//' \item{\code{getSelectionTrace()}}{Get a \code{data.frame} which indicates
+//'   for every iteration if the cross products were computed from scratch
+//'   (\code{full.sweep}).}
+//' }
+//'
+//' @examples
+//'
+//' # Define optimizer which caches the cross products of the last 10 selected
+//' # base-learners:
+//' optimizer = OptimizerCachedCoordinateDescent$new(10)
+//'
+//' @export OptimizerCachedCoordinateDescent
+class OptimizerCachedCoordinateDescent : public OptimizerWrapper
+{
+private:
+  unsigned int n_cached = 50;
+
+public:
+  OptimizerCachedCoordinateDescent ()
+  {
+    obj = new optimizer::OptimizerCachedCoordinateDescent(n_cached);
+  }
+
+  OptimizerCachedCoordinateDescent (const unsigned int& n_cached)
+    : n_cached ( n_cached )
+  {
+    obj = new optimizer::OptimizerCachedCoordinateDescent(n_cached);
+  }
+
+  unsigned int getNumberOfCached () { return n_cached; }
+
+  unsigned int getNumberOfCachedBaselearner ()
+  {
+    return static_cast<optimizer::OptimizerCachedCoordinateDescent*>(obj)->getNumberOfCachedFactories();
+  }
+
+  Rcpp::DataFrame getSelectionTrace ()
+  {
+    optimizer::OptimizerCachedCoordinateDescent* cached_optimizer = static_cast<optimizer::OptimizerCachedCoordinateDescent*>(obj);
+    std::vector<bool> full_sweeps = cached_optimizer->getFullSweeps();
+    return Rcpp::DataFrame::create(
+      Rcpp::Named("iteration")  = Rcpp::seq_len(full_sweeps.size()),
+      Rcpp::Named("full.sweep") = Rcpp::wrap(full_sweeps)
+    );
+  }
+};
+
 RCPP_EXPOSED_CLASS(OptimizerWrapper)
 RCPP_MODULE(optimizer_module)
 {
@@ -2016,6 +2787,42 @@ RCPP_MODULE(optimizer_module)
     .derives<OptimizerWrapper> ("Optimizer")
     .constructor ()
   ;
+
+  class_<OptimizerCoordinateDescentLineSearch> ("OptimizerCoordinateDescentLineSearch")
+    .derives<OptimizerWrapper> ("Optimizer")
+    .constructor ()
+    .method("getStepSize", &OptimizerCoordinateDescentLineSearch::getStepSize, "Get the step size of every iteration")
+  ;
+
+  class_<OptimizerRandomCoordinateDescent> ("OptimizerRandomCoordinateDescent")
+    .derives<OptimizerWrapper> ("Optimizer")
+    .constructor<double, unsigned int, unsigned int> ()
+    .method("getFraction", &OptimizerRandomCoordinateDescent::getFraction, "Get the fraction of evaluated base-learners")
+    .method("getWindow",   &OptimizerRandomCoordinateDescent::getWindow, "Get the window within every base-learner is evaluated")
+  ;
+
+  class_<OptimizerLazyCoordinateDescent> ("OptimizerLazyCoordinateDescent")
+    .derives<OptimizerWrapper> ("Optimizer")
+    .constructor ()
+    .method("getPruningStatistics", &OptimizerLazyCoordinateDescent::getPruningStatistics, "Get the number of evaluated and pruned base-learners per iteration")
+  ;
+
+  class_<OptimizerWorkingSetCoordinateDescent> ("OptimizerWorkingSetCoordinateDescent")
+    .derives<OptimizerWrapper> ("Optimizer")
+    .constructor<unsigned int, unsigned int> ()
+    .method("getNumberOfWorkingSet", &OptimizerWorkingSetCoordinateDescent::getNumberOfWorkingSet, "Get the number of base-learners in the working set")
+    .method("getRefreshIterations",  &OptimizerWorkingSetCoordinateDescent::getRefreshIterations, "Get the number of iterations between two full sweeps")
+    .method("getSelectionTrace",     &OptimizerWorkingSetCoordinateDescent::getSelectionTrace, "Get the iterations selected by a full sweep")
+  ;
+
+  class_<OptimizerCachedCoordinateDescent> ("OptimizerCachedCoordinateDescent")
+    .derives<OptimizerWrapper> ("Optimizer")
+    .constructor ()
+    .constructor<unsigned int> ()
+    .method("getNumberOfCached",            &OptimizerCachedCoordinateDescent::getNumberOfCached, "Get the maximal number of cached base-learners")
+    .method("getNumberOfCachedBaselearner", &OptimizerCachedCoordinateDescent::getNumberOfCachedBaselearner, "Get the number of cached base-learners")
+    .method("getSelectionTrace",            &OptimizerCachedCoordinateDescent::getSelectionTrace, "Get the iterations with cross products computed from scratch")
+  ;
 }
 
 
@@ -2036,6 +2843,8 @@ RCPP_MODULE(optimizer_module)
 //' \preformatted{
 //' Compboost$new(response, learning_rate, stop_if_all_stopper_fulfilled,
 //'   factory_list, loss, logger_list, optimizer)
+//'
+//' Compboost$new(file_name)
 //' }
 //'
 //' @section Arguments:
@@ -2065,6 +2874,10 @@ RCPP_MODULE(optimizer_module)
 //'   The optimizer which is used to select in each iteration one good
 //'   base-learner.
 //' }
+//' \item{\code{file_name} [\code{character(1)}]}{
+//'   Path of a file written by \code{saveModel()}. The model is restored
+//'   without any training data and can just be used for prediction.
+//' }
 //' }
 //'
 //' @section Details:
@@ -2073,6 +2886,17 @@ RCPP_MODULE(optimizer_module)
 //'   the functionality of the \code{C++} class visit
 //'   \url{https://schalkdaniel.github.io/compboost/cpp_man/html/classcboost_1_1_compboost.html}.
 //'
+//'   A trained model can be stored by \code{saveModel()} and restored by
+//'   \code{Compboost_internal$new(file_name)}. The file contains the offset,
+//'   the estimated parameter of the actual iteration, how often each
+//'   base-learner is selected, and the configuration of the factories (e.g.
+//'   the knots of the splines). Just polynomial and spline base-learner can
+//'   be saved. Neither the parameter of every iteration, nor the training
+//'   data and the design matrices are stored, hence a loaded model can't be
+//'   trained further or set to another iteration, and \code{getPrediction()}
+//'   is not available. Custom losses are restored with the identity as
+//'   response function.
+//'
 //' @section Fields:
 //'   This class doesn't contain public fields.
 //'
@@ -2088,6 +2912,8 @@ RCPP_MODULE(optimizer_module)
 //'   the fitting process.}
 //' \item{\code{getSelectedBaselearner()}}{Returns a character vector of how
 //'   the base-learner are selected.}
+//' \item{\code{getSelectionCounts()}}{Returns a named vector of how often each
+//'   base-learner is selected up to the actual iteration.}
 //' \item{\code{getLoggerData()}}{Returns a list of all logged data. If the
 //'   algorithm is retrained, then the list contains for each training one
 //'   element.}
@@ -2108,7 +2934,61 @@ RCPP_MODULE(optimizer_module)
 //' \item{\code{setToIteration(k)}}{Set the whole model to another iteration
 //'   \code{k}. After calling this function all other elements such as the
 //'   parameters or the prediction are calculated corresponding to \code{k}.}
+//' \item{\code{setPrecompiledPrediction(use_precompiled)}}{If \code{TRUE},
+//'   the cumulated effects of univariate polynomial and spline base-learner
+//'   are converted into piecewise polynomials. Prediction on new data is then
+//'   done by a span lookup and a Horner scheme instead of creating the basis
+//'   of each new observation. The result is exact up to rounding errors.}
 //' \item{\code{summarizeCompboost()}}{Summarize the \code{Compboost} object.}
+//' \item{\code{trainAsync()}}{Initial training in a background thread. The
+//'   function returns immediately. Custom losses or base-learner which call
+//'   \code{R} functions are not allowed. While the model is trained, all
+//'   methods except the following ones throw an error.}
+//' \item{\code{continueTrainingAsync(logger_list)}}{Continue the training in
+//'   a background thread.}
+//' \item{\code{getTrainingStatus()}}{Returns a list with the status of the
+//'   background training, the current iteration, the risk, and the logger
+//'   data. The data is updated at most every 100 milliseconds.}
+//' \item{\code{pauseTraining()}, \code{resumeTraining()}}{Pause or resume
+//'   the background training.}
+//' \item{\code{cancelTraining()}}{Stop the background training after the
+//'   current iteration. The model keeps all finished iterations.}
+//' \item{\code{waitForTraining()}}{Block until the background training is
+//'   finished. Errors of the training are thrown here.}
+//' \item{\code{saveModel(file_name)}}{Write the trained model into a binary
+//'   file which can be loaded by \code{Compboost_internal$new(file_name)}.}
+//' \item{\code{setCheckpoint(file_name, every_iterations, every_seconds)}}{
+//'   Write a checkpoint of the initial training every \code{every_iterations}
+//'   iterations or every \code{every_seconds} seconds (\code{0} deactivates
+//'   the criteria). The checkpoint is written in the background without
+//'   stalling the training. An empty \code{file_name} deactivates the
+//'   checkpoints.}
+//' \item{\code{trainFromCheckpoint(file_name, trace)}}{Resume the initial
+//'   training from a checkpoint. The model must be defined as the one which
+//'   has written the checkpoint (same data, factories, and logger). The
+//'   resumed model equals the one of an uninterrupted training.}
+//' \item{\code{setRowSubsampling(fraction, seed)}}{Stochastic gradient
+//'   boosting. In every iteration, the pseudo residuals are computed and the
+//'   base-learners are trained and selected on a new random subsample of
+//'   \code{fraction} of the rows. The prediction of all rows is updated with
+//'   the selected base-learner. Custom base-learners and targets which are
+//'   binned, chunked, or in single precision can't be trained on a
+//'   subsample. The state of the random number generator is not part of
+//'   a checkpoint.}
+//' \item{\code{setAcceleration(use_momentum)}}{Accelerated boosting with
+//'   Nesterov's momentum. The pseudo residuals are computed at the prediction
+//'   plus the momentum times the update of the last iteration. The
+//'   parameter of every iteration includes the momentum. Accelerated models
+//'   can't write checkpoints and can't be saved.}
+//' \item{\code{setNewtonSteps(use_newton)}}{Second order boosting. The
+//'   base-learners are fitted to the pseudo residuals divided by the second
+//'   derivative of the loss, weighted by the second derivative. Hence, every
+//'   iteration is a Newton step. Requires a loss with second derivative
+//'   (\code{LossQuadratic} or \code{LossBinomial}) and polynomial or spline
+//'   base-learners which aren't binned, chunked, or in single precision.}
+//' \item{\code{setRiskEvery(every)}}{Compute the risk of the training data
+//'   just every \code{every} iterations, for the printed trace, and for the
+//'   last iteration. The risk of all other iterations is \code{NaN}.}
 //' }
 //' @examples
 //'
@@ -2209,6 +3089,12 @@ RCPP_MODULE(optimizer_module)
 //' # Get new parameter values:
 //' cboost$getEstimatedParameter()
 //'
+//' # Save the model and restore it for prediction:
+//' model.file = tempfile()
+//' cboost$saveModel(model.file)
+//' cboost.loaded = Compboost_internal$new(model.file)
+//' cboost.loaded$predict(test.data, FALSE)
+//'
 //' @export Compboost_internal
 class CompboostWrapper
 {
@@ -2233,30 +3119,107 @@ public:
       used_optimizer, loss.getLoss(), used_logger, *blearner_list_ptr);
   }
 
+  // Restore a saved model, all components are then owned by the model:
+  CompboostWrapper (std::string file_name)
+  {
+    obj = new cboost::Compboost(file_name);
+    is_trained = true;
+  }
+
   // Member functions
   void train (unsigned int trace)
   {
+    checkTrainingThread();
     obj->trainCompboost(trace);
     is_trained = true;
   }
 
   void continueTraining (unsigned int trace, LoggerListWrapper& logger_list)
   {
+    checkTrainingThread();
     obj->continueTraining(logger_list.getLoggerList(), trace);
   }
 
+  void trainAsync ()
+  {
+    checkTrainingThread();
+    obj->trainCompboostAsync();
+    is_trained = true;
+  }
+
+  void continueTrainingAsync (LoggerListWrapper& logger_list)
+  {
+    checkTrainingThread();
+    obj->continueTrainingAsync(logger_list.getLoggerList());
+  }
+
+  Rcpp::List getTrainingStatus ()
+  {
+    std::shared_ptr<const cboost::TrainingSnapshot> snapshot = obj->getTrainingSnapshot();
+
+    if (! snapshot) {
+      return Rcpp::List::create(
+        Rcpp::Named("running")   = false,
+        Rcpp::Named("paused")    = false,
+        Rcpp::Named("iteration") = 0
+      );
+    }
+    return Rcpp::List::create(
+      Rcpp::Named("running")      = obj->isTrainingRunning(),
+      Rcpp::Named("paused")       = obj->isTrainingPaused(),
+      Rcpp::Named("iteration")    = snapshot->iteration,
+      Rcpp::Named("risk")         = snapshot->risk,
+      Rcpp::Named("logger.names") = snapshot->logger_data.first,
+      Rcpp::Named("logger.data")  = snapshot->logger_data.second
+    );
+  }
+
+  void pauseTraining ()
+  {
+    obj->pauseTraining(true);
+  }
+
+  void resumeTraining ()
+  {
+    obj->pauseTraining(false);
+  }
+
+  void cancelTraining ()
+  {
+    obj->cancelTraining();
+  }
+
+  void waitForTraining ()
+  {
+    // Poll to keep the R session responsive for user interrupts:
+    while (obj->isTrainingRunning()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      Rcpp::checkUserInterrupt();
+    }
+    obj->joinTraining();
+  }
+
   arma::vec getPrediction (bool as_response)
   {
+    checkTrainingThread();
     return obj->getPrediction(as_response);
   }
 
   std::vector<std::string> getSelectedBaselearner ()
   {
+    checkTrainingThread();
     return obj->getSelectedBaselearner();
   }
 
+  std::map<std::string, unsigned int> getSelectionCounts ()
+  {
+    checkTrainingThread();
+    return obj->getSelectionCounts();
+  }
+
   Rcpp::List getLoggerData ()
   {
+    checkTrainingThread();
     Rcpp::List out_list;
 
     for (auto& it : obj->getLoggerList()) {
@@ -2274,6 +3237,7 @@ public:
 
   Rcpp::List getEstimatedParameter ()
   {
+    checkTrainingThread();
     std::map<std::string, arma::mat> parameter = obj->getParameter();
 
     Rcpp::List out;
@@ -2286,6 +3250,7 @@ public:
 
   Rcpp::List getParameterAtIteration (unsigned int k)
   {
+    checkTrainingThread();
     std::map<std::string, arma::mat> parameter = obj->getParameterOfIteration(k);
 
     Rcpp::List out;
@@ -2298,6 +3263,7 @@ public:
 
   Rcpp::List getParameterMatrix ()
   {
+    checkTrainingThread();
     std::pair<std::vector<std::string>, arma::mat> out_pair = obj->getParameterMatrix();
 
     return Rcpp::List::create(
@@ -2308,6 +3274,7 @@ public:
 
   arma::vec predict (Rcpp::List& newdata, bool as_response)
   {
+    checkTrainingThread();
     std::map<std::string, data::Data*> data_map;
 
     // Create data map (see line 780, same applies here):
@@ -2325,6 +3292,7 @@ public:
 
   arma::vec predictAtIteration (Rcpp::List& newdata, unsigned int k, bool as_response)
   {
+    checkTrainingThread();
     std::map<std::string, data::Data*> data_map;
 
     // Create data map (see line 780, same applies here):
@@ -2342,6 +3310,7 @@ public:
 
   void summarizeCompboost ()
   {
+    checkTrainingThread();
     obj->summarizeCompboost();
   }
 
@@ -2352,19 +3321,71 @@ public:
 
   double getOffset ()
   {
+    checkTrainingThread();
     return obj->getOffset();
   }
 
   std::vector<double> getRiskVector ()
   {
+    checkTrainingThread();
     return obj->getRiskVector();
   }
 
   void setToIteration (const unsigned int& k)
   {
+    checkTrainingThread();
     obj->setToIteration(k);
   }
 
+  void setPrecompiledPrediction (bool use_precompiled)
+  {
+    checkTrainingThread();
+    obj->setPrecompiledPrediction(use_precompiled);
+  }
+
+  void saveModel (std::string file_name)
+  {
+    checkTrainingThread();
+    obj->saveModel(file_name);
+  }
+
+  void setCheckpoint (std::string file_name, unsigned int every_iterations, double every_seconds)
+  {
+    checkTrainingThread();
+    obj->setCheckpoint(file_name, every_iterations, every_seconds);
+  }
+
+  void setRowSubsampling (double fraction, unsigned int seed)
+  {
+    checkTrainingThread();
+    obj->setRowSubsampling(fraction, seed);
+  }
+
+  void setAcceleration (bool use_momentum)
+  {
+    checkTrainingThread();
+    obj->setAcceleration(use_momentum);
+  }
+
+  void setNewtonSteps (bool use_newton)
+  {
+    checkTrainingThread();
+    obj->setNewtonSteps(use_newton);
+  }
+
+  void setRiskEvery (unsigned int every)
+  {
+    checkTrainingThread();
+    obj->setRiskEvery(every);
+  }
+
+  void trainFromCheckpoint (std::string file_name, unsigned int trace)
+  {
+    checkTrainingThread();
+    obj->trainFromCheckpoint(file_name, trace);
+    is_trained = true;
+  }
+
   // Destructor:
   ~CompboostWrapper ()
   {
@@ -2373,6 +3394,16 @@ public:
 
 private:
 
+  // Most of the methods access the model, which is not allowed while it is
+  // trained in the background. A finished training thread is joined here:
+  void checkTrainingThread ()
+  {
+    if (obj->isTrainingRunning()) {
+      Rcpp::stop("The model is trained in the background. Use 'waitForTraining()' or 'cancelTraining()' first.");
+    }
+    obj->joinTraining();
+  }
+
   blearnerlist::BaselearnerFactoryList* blearner_list_ptr;
   loggerlist::LoggerList* used_logger;
   optimizer::Optimizer* used_optimizer;
@@ -2393,10 +3424,12 @@ RCPP_MODULE (compboost_module)
 
   class_<CompboostWrapper> ("Compboost_internal")
     .constructor<arma::vec, double, bool, BlearnerFactoryListWrapper&, LossWrapper&, LoggerListWrapper&, OptimizerWrapper&> ()
+    .constructor<std::string> ()
     .method("train", &CompboostWrapper::train, "Run componentwise boosting")
     .method("continueTraining", &CompboostWrapper::continueTraining, "Continue Training")
     .method("getPrediction", &CompboostWrapper::getPrediction, "Get prediction")
     .method("getSelectedBaselearner", &CompboostWrapper::getSelectedBaselearner, "Get vector of selected base-learner")
+    .method("getSelectionCounts", &CompboostWrapper::getSelectionCounts, "Get how often each base-learner is selected")
     .method("getLoggerData", &CompboostWrapper::getLoggerData, "Get data of the used logger")
     .method("getEstimatedParameter", &CompboostWrapper::getEstimatedParameter, "Get the estimated paraemter")
     .method("getParameterAtIteration", &CompboostWrapper::getParameterAtIteration, "Get the estimated parameter for iteration k < iter.max")
@@ -2408,6 +3441,21 @@ RCPP_MODULE (compboost_module)
     .method("setToIteration", &CompboostWrapper::setToIteration, "Set state of the model to a given iteration")
     .method("getOffset", &CompboostWrapper::getOffset, "Get offset.")
     .method("getRiskVector", &CompboostWrapper::getRiskVector, "Get the risk vector.")
+    .method("setPrecompiledPrediction", &CompboostWrapper::setPrecompiledPrediction, "Use piecewise polynomials to predict univariate effects")
+    .method("trainAsync", &CompboostWrapper::trainAsync, "Run componentwise boosting in a background thread")
+    .method("continueTrainingAsync", &CompboostWrapper::continueTrainingAsync, "Continue training in a background thread")
+    .method("getTrainingStatus", &CompboostWrapper::getTrainingStatus, "Get the progress of the background training")
+    .method("pauseTraining", &CompboostWrapper::pauseTraining, "Pause the background training")
+    .method("resumeTraining", &CompboostWrapper::resumeTraining, "Resume the background training")
+    .method("cancelTraining", &CompboostWrapper::cancelTraining, "Cancel the background training")
+    .method("waitForTraining", &CompboostWrapper::waitForTraining, "Wait until the background training is finished")
+    .method("saveModel", &CompboostWrapper::saveModel, "Save the trained model into a binary file")
+    .method("setCheckpoint", &CompboostWrapper::setCheckpoint, "Write checkpoints while training")
+    .method("setRowSubsampling", &CompboostWrapper::setRowSubsampling, "Train every iteration on a subsample of the rows")
+    .method("setAcceleration", &CompboostWrapper::setAcceleration, "Accelerate the training by Nesterov's momentum")
+    .method("setNewtonSteps", &CompboostWrapper::setNewtonSteps, "Use the second derivative of the loss for Newton steps")
+    .method("setRiskEvery", &CompboostWrapper::setRiskEvery, "Compute the risk just every given number of iterations")
+    .method("trainFromCheckpoint", &CompboostWrapper::trainFromCheckpoint, "Resume the initial training from a checkpoint")
   ;
 }
 
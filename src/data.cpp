@@ -35,6 +35,21 @@
 
 #include "data.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm> // ::min
+#include <cstdio>    // ::remove
+#include <stdexcept> // ::runtime_error
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace data
 {
 
@@ -45,6 +60,16 @@ void Data::setDataIdentifier (const std::string& new_data_identifier)
   data_identifier = new_data_identifier;
 }
 
+// Sources reference their raw data. Other data objects which are used as 
+// new data (e.g. a subsample of the rows) hold it within their data matrix:
+const arma::mat& Data::getSourceData () const
+{
+  if (data_mat_ptr != NULL) {
+    return *data_mat_ptr;
+  }
+  return data_mat;
+}
+
 std::string Data::getDataIdentifier () const 
 {
   return data_identifier;
@@ -55,6 +80,395 @@ void Data::setDataType (const std::string& data_type0)
   data_type = data_type0;
 }
 
+void Data::setPreparationTag (const std::string& preparation_tag0)
+{
+  preparation_tag = preparation_tag0;
+}
+
+std::string Data::getPreparationTag () const
+{
+  return preparation_tag;
+}
+
+void Data::markAsUsedByFactory ()
+{
+  used_by_factory = true;
+}
+
+bool Data::isUsedByFactory () const
+{
+  return used_by_factory;
+}
+
+/**
+ * \brief Check that a target can be prepared for a transformation
+ * 
+ * A target which is already used by a factory can just be shared with other
+ * factories which use the same transformation (same preparation tag), 
+ * otherwise the data of the other factories would be overwritten.
+ * 
+ * \param preparation_tag0 `std::string` tag of the new transformation
+ */
+void Data::checkPreparation (const std::string& preparation_tag0) const
+{
+  if (used_by_factory && (preparation_tag != preparation_tag0)) {
+    Rcpp::stop("The target is already used by a factory with another transformation and can't be prepared again.");
+  }
+}
+
+// By default the design matrix is stored in memory:
+bool Data::isChunked () const
+{
+  return false;
+}
+
+/**
+ * \brief Opt-in to store the design matrix in single precision
+ * 
+ * This halves the memory and the bandwidth which is needed to read the 
+ * design matrix in every iteration. It must be set before the object is
+ * passed as target to a factory.
+ * 
+ * \param use_single_precision0 `bool` flag to store floats
+ */
+void Data::setSinglePrecision (const bool& use_single_precision0)
+{
+  if (data_mat_ptr != NULL) {
+    Rcpp::stop("Single precision can just be used for target data.");
+  }
+  if (preparation_tag != "") {
+    Rcpp::stop("The data is already prepared by a factory. Set the precision before passing the target to a factory.");
+  }
+  use_single_precision = use_single_precision0;
+}
+
+bool Data::usesSinglePrecision () const
+{
+  return use_single_precision;
+}
+
+bool Data::hasSinglePrecisionData () const
+{
+  return (data_mat_float.n_elem > 0) || (sparse_data_mat_float.n_nonzero > 0);
+}
+
+/**
+ * \brief Replace the prepared design matrix by its single precision version
+ * 
+ * Nothing happens if single precision isn't requested. Everything else which
+ * is computed by the factory (e.g. the cross product) is kept in 
+ * double precision.
+ */
+void Data::convertToSinglePrecision ()
+{
+  if (! use_single_precision || hasSinglePrecisionData()) { return; }
+  
+  if (sparse_data_mat.n_nonzero > 0) {
+    sparse_data_mat.sync();
+    
+    arma::uvec row_indices (sparse_data_mat.row_indices, sparse_data_mat.n_nonzero);
+    arma::uvec col_ptrs (sparse_data_mat.col_ptrs, sparse_data_mat.n_cols + 1);
+    arma::fvec values = arma::conv_to<arma::fvec>::from(arma::vec(sparse_data_mat.values, sparse_data_mat.n_nonzero));
+    
+    sparse_data_mat_float = arma::sp_fmat(row_indices, col_ptrs, values, sparse_data_mat.n_rows, sparse_data_mat.n_cols);
+    sparse_data_mat = arma::sp_mat();
+  } else {
+    data_mat_float = arma::conv_to<arma::fmat>::from(data_mat);
+    data_mat = arma::mat();
+  }
+}
+
+// Just the values of the design matrix which is used are counted (the dense
+// matrix of a sparse target is a placeholder). The indices of sparse matrices
+// are the same for both precisions:
+unsigned int Data::getDesignBytes () const
+{
+  if (sparse_data_mat_float.n_nonzero > 0) {
+    return sparse_data_mat_float.n_nonzero * sizeof(float);
+  }
+  if (data_mat_float.n_elem > 0) {
+    return data_mat_float.n_elem * sizeof(float);
+  }
+  if (sparse_data_mat.n_nonzero > 0) {
+    return sparse_data_mat.n_nonzero * sizeof(double);
+  }
+  return data_mat.n_elem * sizeof(double);
+}
+
+/**
+ * \brief Compute \f$X^T r\f$ with the single precision design matrix
+ * 
+ * The sparse matrix has the transposed layout (one column per observation)
+ * as the double precision one. The values are read as float but the sums 
+ * are accumulated in double.
+ * 
+ * \param response `arma::vec` vector with one element per observation
+ * 
+ * \returns `arma::vec` with one element per column of the design matrix
+ */
+arma::vec Data::crossprodSinglePrecision (const arma::vec& response) const
+{
+  if (sparse_data_mat_float.n_nonzero > 0) {
+    sparse_data_mat_float.sync();
+    arma::vec out (sparse_data_mat_float.n_rows, arma::fill::zeros);
+    
+    for (unsigned int j = 0; j < sparse_data_mat_float.n_cols; j++) {
+      for (unsigned int k = sparse_data_mat_float.col_ptrs[j]; k < sparse_data_mat_float.col_ptrs[j + 1]; k++) {
+        out[sparse_data_mat_float.row_indices[k]] += static_cast<double>(sparse_data_mat_float.values[k]) * response[j];
+      }
+    }
+    return out;
+  }
+  arma::vec out (data_mat_float.n_cols);
+  for (unsigned int c = 0; c < data_mat_float.n_cols; c++) {
+    const float* column = data_mat_float.colptr(c);
+    
+    double sum = 0;
+    for (unsigned int i = 0; i < data_mat_float.n_rows; i++) {
+      sum += static_cast<double>(column[i]) * response[i];
+    }
+    out[c] = sum;
+  }
+  return out;
+}
+
+/**
+ * \brief Compute \f$X b\f$ with the single precision design matrix
+ * 
+ * \param parameter `arma::vec` vector with one element per column of the 
+ *   design matrix
+ * 
+ * \returns `arma::vec` with one element per observation
+ */
+arma::vec Data::multiplySinglePrecision (const arma::vec& parameter) const
+{
+  if (sparse_data_mat_float.n_nonzero > 0) {
+    sparse_data_mat_float.sync();
+    arma::vec out (sparse_data_mat_float.n_cols);
+    
+    for (unsigned int j = 0; j < sparse_data_mat_float.n_cols; j++) {
+      double sum = 0;
+      for (unsigned int k = sparse_data_mat_float.col_ptrs[j]; k < sparse_data_mat_float.col_ptrs[j + 1]; k++) {
+        sum += static_cast<double>(sparse_data_mat_float.values[k]) * parameter[sparse_data_mat_float.row_indices[k]];
+      }
+      out[j] = sum;
+    }
+    return out;
+  }
+  arma::vec out (data_mat_float.n_rows, arma::fill::zeros);
+  for (unsigned int c = 0; c < data_mat_float.n_cols; c++) {
+    const float* column = data_mat_float.colptr(c);
+    
+    for (unsigned int i = 0; i < data_mat_float.n_rows; i++) {
+      out[i] += static_cast<double>(column[i]) * parameter[c];
+    }
+  }
+  return out;
+}
+
+/**
+ * \brief Opt-in to quantize the feature of a target into bins
+ * 
+ * Instead of the design matrix, the target then stores the bin of each 
+ * observation (two bytes) and the design matrix of the bins. The training
+ * just sums the pseudo residuals per bin. This must be set before the object
+ * is passed as target to a factory.
+ * 
+ * \param n_bins0 `unsigned int` number of bins (zero disables binning)
+ */
+void Data::setBinning (const unsigned int& n_bins0)
+{
+  if (data_mat_ptr != NULL) {
+    Rcpp::stop("Binning can just be used for target data.");
+  }
+  if (preparation_tag != "") {
+    Rcpp::stop("The data is already prepared by a factory. Set the binning before passing the target to a factory.");
+  }
+  if (n_bins0 == 1 || n_bins0 > 65536) {
+    Rcpp::stop("The number of bins must be between 2 and 65536.");
+  }
+  n_bins = n_bins0;
+}
+
+unsigned int Data::getNumberOfBins () const
+{
+  return n_bins;
+}
+
+bool Data::hasBinnedData () const
+{
+  return bin_idx.size() > 0;
+}
+
+/**
+ * \brief Quantize a feature into equally sized bins
+ * 
+ * Sets the bin of each observation and the number of observations per bin.
+ * Each bin is represented by the mean of its values which reduces the 
+ * approximation error compared to the center of the bin. Empty bins are 
+ * represented by their centers.
+ * 
+ * \param raw_data `arma::mat` feature with one column
+ * 
+ * \returns `arma::vec` with the value of each bin
+ */
+arma::vec Data::createBins (const arma::mat& raw_data)
+{
+  if (raw_data.n_cols != 1) {
+    Rcpp::stop("Binning is just supported for one feature.");
+  }
+  double min_value = raw_data.min();
+  double bin_width = (raw_data.max() - min_value) / n_bins;
+  
+  arma::vec bin_values (n_bins, arma::fill::zeros);
+  bin_counts = arma::vec (n_bins, arma::fill::zeros);
+  bin_idx.resize(raw_data.n_rows);
+  
+  for (unsigned int i = 0; i < raw_data.n_rows; i++) {
+    unsigned int bin = 0;
+    if (bin_width > 0) {
+      bin = std::min<unsigned int>((raw_data(i, 0) - min_value) / bin_width, n_bins - 1);
+    }
+    bin_idx[i] = bin;
+    bin_values[bin] += raw_data(i, 0);
+    bin_counts[bin] += 1;
+  }
+  for (unsigned int b = 0; b < n_bins; b++) {
+    if (bin_counts[b] > 0) {
+      bin_values[b] /= bin_counts[b];
+    } else {
+      bin_values[b] = min_value + (b + 0.5) * bin_width;
+    }
+  }
+  return bin_values;
+}
+
+arma::vec Data::sumPerBin (const arma::vec& x) const
+{
+  arma::vec out (bin_counts.n_elem, arma::fill::zeros);
+  for (unsigned int i = 0; i < bin_idx.size(); i++) {
+    out[bin_idx[i]] += x[i];
+  }
+  return out;
+}
+
+arma::vec Data::expandBins (const arma::vec& bin_values) const
+{
+  arma::vec out (bin_idx.size());
+  for (unsigned int i = 0; i < bin_idx.size(); i++) {
+    out[i] = bin_values[bin_idx[i]];
+  }
+  return out;
+}
+
+/**
+ * \brief Compute \f$X^T r\f$ with the binned design matrix
+ * 
+ * Observations of the same bin share the same row of the design matrix, 
+ * hence \f$X^T r\f$ equals the transposed design matrix of the bins times
+ * the sums of \f$r\f$ per bin.
+ * 
+ * \param response `arma::vec` vector with one element per observation
+ * 
+ * \returns `arma::vec` with one element per column of the design matrix
+ */
+arma::vec Data::crossprodBins (const arma::vec& response) const
+{
+  return bin_data_mat.t() * sumPerBin(response);
+}
+
+arma::vec Data::multiplyBins (const arma::vec& parameter) const
+{
+  return expandBins(bin_data_mat * parameter);
+}
+
+/**
+ * \brief Store prepared target data into a binary file
+ * 
+ * All members which are set by a factory are written, that are the dense or
+ * sparse design matrix, the knots, and the cross product (and its inverse
+ * for the polynomial factory). The layout is columnar: every matrix is 
+ * written as one contiguous block of doubles behind its dimension.
+ * 
+ * \param file_name `std::string` path of the new file
+ */
+void Data::saveData (const std::string& file_name) const
+{
+  if (preparation_tag == "") {
+    Rcpp::stop("The data object isn't prepared by a factory. Just target data can be saved.");
+  }
+  if (hasBinnedData()) {
+    Rcpp::stop("Binned data can't be saved.");
+  }
+  std::ofstream out;
+  serialize::openOutputFile(out, file_name);
+  
+  serialize::writeHeader(out, "CBDATA", 2);
+  serialize::writeString(out, data_identifier);
+  serialize::writeString(out, data_type);
+  serialize::writeString(out, preparation_tag);
+  
+  // Single precision data is written as double and converted again by the
+  // factory after loading:
+  serialize::writeMat(out, getData());
+  if (sparse_data_mat_float.n_nonzero > 0) {
+    sparse_data_mat_float.sync();
+    
+    arma::uvec row_indices (sparse_data_mat_float.row_indices, sparse_data_mat_float.n_nonzero);
+    arma::uvec col_ptrs (sparse_data_mat_float.col_ptrs, sparse_data_mat_float.n_cols + 1);
+    arma::vec values = arma::conv_to<arma::vec>::from(arma::fvec(sparse_data_mat_float.values, sparse_data_mat_float.n_nonzero));
+    
+    serialize::writeSpMat(out, arma::sp_mat(row_indices, col_ptrs, values, sparse_data_mat_float.n_rows, sparse_data_mat_float.n_cols));
+  } else {
+    serialize::writeSpMat(out, sparse_data_mat);
+  }
+  serialize::writeMat(out, XtX);
+  serialize::writeMat(out, knots);
+  serialize::writeMat(out, knot_boundaries);
+  serialize::writeMat(out, XtX_inv);
+  
+  if (! out) {
+    Rcpp::stop("Could not write data into file '" + file_name + "'.");
+  }
+}
+
+/**
+ * \brief Restore prepared target data from a binary file
+ * 
+ * The factory which uses this object as target checks the restored 
+ * preparation tag and skips the preparation (e.g. creating the spline basis 
+ * and computing the cross product) if the tag matches.
+ * 
+ * \param file_name `std::string` path of a file written by `saveData()`
+ */
+void Data::loadData (const std::string& file_name)
+{
+  if (data_mat_ptr != NULL) {
+    Rcpp::stop("Data can just be loaded into target data objects.");
+  }
+  std::ifstream in;
+  serialize::openInputFile(in, file_name);
+  
+  uint32_t version = serialize::readHeader(in, "CBDATA");
+  if (version != 2) {
+    Rcpp::stop("Data file '" + file_name + "' has version " + std::to_string(version) + " which is not supported.");
+  }
+  data_identifier = serialize::readString(in);
+  data_type       = serialize::readString(in);
+  preparation_tag = serialize::readString(in);
+  
+  data_mat        = serialize::readMat(in);
+  sparse_data_mat = serialize::readSpMat(in);
+  XtX             = serialize::readMat(in);
+  knots           = serialize::readMat(in);
+  knot_boundaries = serialize::readMat(in);
+  XtX_inv         = serialize::readMat(in);
+  
+  data_mat_float.reset();
+  sparse_data_mat_float = arma::sp_fmat();
+  bin_idx.clear();
+}
+
 
 // -------------------------------------------------------------------------- //
 // Data implementations:
@@ -87,6 +501,16 @@ arma::mat InMemoryData::getData () const
 {
   // Give data depending on source (by reference) or target (by value):
   if (data_mat_ptr == NULL) {
+    if (hasBinnedData()) {
+      arma::mat out (bin_idx.size(), bin_data_mat.n_cols);
+      for (unsigned int i = 0; i < bin_idx.size(); i++) {
+        out.row(i) = bin_data_mat.row(bin_idx[i]);
+      }
+      return out;
+    }
+    if (data_mat_float.n_elem > 0) {
+      return arma::conv_to<arma::mat>::from(data_mat_float);
+    }
     return data_mat;
   } else {
     return *data_mat_ptr;
@@ -97,4 +521,425 @@ InMemoryData::~InMemoryData () {
   // Rcpp::Rcout << "Delete Data" << std::endl;
 }
 
+// MappedData:
+// -----------------------
+
+/**
+ * \brief Map one column of a binary column-major file
+ * 
+ * The offset of a mmap call must be a multiple of the page size. Therefore,
+ * the mapped region starts at the page which contains the first element of
+ * the column and the data pointer is shifted accordingly. The mapped memory
+ * is used directly by an `arma::mat` without copying it.
+ * 
+ * \param file_name0 `std::string` path to the binary file
+ * \param n_rows0 `unsigned int` number of rows of the stored matrix
+ * \param column0 `unsigned int` column which should be mapped (starting at 0)
+ * \param data_identifier0 `std::string` name of the data
+ */
+MappedData::MappedData (const std::string& file_name0, const unsigned int& n_rows0, 
+  const unsigned int& column0, const std::string& data_identifier0)
+  : file_name ( file_name0 ),
+    n_rows ( n_rows0 ),
+    column ( column0 )
+{
+  data_identifier = data_identifier0;
+  
+#ifdef _WIN32
+  Rcpp::stop("MappedData is not supported on Windows.");
+#else
+  if (n_rows == 0) {
+    Rcpp::stop("The number of rows must be greater than zero.");
+  }
+  int file_descriptor = open(file_name.c_str(), O_RDONLY);
+  if (file_descriptor == -1) {
+    Rcpp::stop("Could not open file '" + file_name + "'.");
+  }
+  struct stat file_stat;
+  if (fstat(file_descriptor, &file_stat) == -1) {
+    close(file_descriptor);
+    Rcpp::stop("Could not get the size of file '" + file_name + "'.");
+  }
+  std::size_t column_bytes = static_cast<std::size_t>(n_rows) * sizeof(double);
+  std::size_t file_size = static_cast<std::size_t>(file_stat.st_size);
+  
+  if ((file_size % column_bytes) != 0) {
+    close(file_descriptor);
+    Rcpp::stop("The size of file '" + file_name + "' is not a multiple of " + std::to_string(n_rows) + " doubles.");
+  }
+  if (column >= file_size / column_bytes) {
+    close(file_descriptor);
+    Rcpp::stop("File '" + file_name + "' just contains " + std::to_string(file_size / column_bytes) + " columns.");
+  }
+  std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  std::size_t column_offset = column * column_bytes;
+  std::size_t page_offset = column_offset - (column_offset % page_size);
+  
+  mapped_length = column_offset - page_offset + column_bytes;
+  mapped_region = mmap(NULL, mapped_length, PROT_READ, MAP_PRIVATE, file_descriptor, page_offset);
+  
+  // The mapping keeps its own reference to the file:
+  close(file_descriptor);
+  
+  if (mapped_region == MAP_FAILED) {
+    mapped_region = NULL;
+    Rcpp::stop("Could not map file '" + file_name + "' into memory.");
+  }
+  // The column is read from top to bottom:
+  madvise(mapped_region, mapped_length, MADV_SEQUENTIAL);
+  
+  double* column_ptr = reinterpret_cast<double*>(static_cast<char*>(mapped_region) + (column_offset - page_offset));
+  mapped_mat = arma::mat(column_ptr, n_rows, 1, false, true);
+  data_mat_ptr = &mapped_mat;
+#endif
+}
+
+void MappedData::setData (const arma::mat& transformed_data)
+{
+  Rcpp::stop("MappedData is read only and can't be used as target data.");
+}
+
+arma::mat MappedData::getData () const
+{
+  return mapped_mat;
+}
+
+std::string MappedData::getFileName () const
+{
+  return file_name;
+}
+
+unsigned int MappedData::getColumn () const
+{
+  return column;
+}
+
+MappedData::~MappedData ()
+{
+#ifndef _WIN32
+  if (mapped_region != NULL) {
+    munmap(mapped_region, mapped_length);
+  }
+#endif
+}
+
+// ChunkedData:
+// -----------------------
+
+/**
+ * \brief Create an empty chunked target
+ * 
+ * The chunks are written by a factory (e.g. the spline factory). The file
+ * is just a storage for the chunks of this object and is removed when the 
+ * object is deleted.
+ * 
+ * \param file_name0 `std::string` path of the file for the chunks
+ * \param chunk_size0 `unsigned int` number of rows per chunk
+ */
+ChunkedData::ChunkedData (const std::string& file_name0, const unsigned int& chunk_size0)
+  : file_name ( file_name0 ),
+    chunk_size ( chunk_size0 )
+{
+  if (chunk_size == 0) {
+    Rcpp::stop("The number of rows per chunk must be greater than zero.");
+  }
+}
+
+void ChunkedData::setData (const arma::mat& transformed_data)
+{
+  Rcpp::stop("ChunkedData is filled chunk by chunk and can just be used as target of spline factories.");
+}
+
+arma::mat ChunkedData::getData () const
+{
+  arma::mat out (n_rows, n_cols, arma::fill::zeros);
+  
+  forEachChunk([&out, this] (const DataChunk& chunk) {
+    for (unsigned int j = 0; j < chunk.band_start.size(); j++) {
+      for (unsigned int b = 0; b < band_width; b++) {
+        out(chunk.first_row + j, chunk.band_start[j] + b) = chunk.band_values(b, j);
+      }
+    }
+  });
+  return out;
+}
+
+bool ChunkedData::isChunked () const
+{
+  return true;
+}
+
+void ChunkedData::startChunks (const unsigned int& n_cols0, const unsigned int& band_width0)
+{
+  if (band_width0 == 0 || band_width0 > n_cols0) {
+    Rcpp::stop("The band width must be between one and the number of columns.");
+  }
+  if (chunk_writer.is_open()) {
+    chunk_writer.close();
+  }
+  n_rows     = 0;
+  n_cols     = n_cols0;
+  band_width = band_width0;
+  chunk_offsets.clear();
+  chunk_first_row.clear();
+  
+  serialize::openOutputFile(chunk_writer, file_name);
+}
+
+/**
+ * \brief Append the next rows of the design matrix
+ * 
+ * The transposed layout (one column per observation) is the one which is
+ * also used for the sparse in memory data, it allows to read the non zero
+ * entries of one observation directly from the compressed columns. Bands 
+ * which would exceed the last column are shifted to the left to keep all
+ * indices within the matrix.
+ * 
+ * \param basis_t `arma::sp_mat` transposed design matrix of the next rows
+ */
+void ChunkedData::appendChunk (const arma::sp_mat& basis_t)
+{
+  if (! chunk_writer.is_open()) {
+    Rcpp::stop("Chunks must be started before they can be appended.");
+  }
+  if (basis_t.n_rows != n_cols) {
+    Rcpp::stop("The chunk has " + std::to_string(basis_t.n_rows) + " columns but " + std::to_string(n_cols) + " are expected.");
+  }
+  basis_t.sync();
+  
+  unsigned int n_chunk_rows = basis_t.n_cols;
+  std::vector<uint32_t> band_start (n_chunk_rows, 0);
+  arma::mat band_values (band_width, n_chunk_rows, arma::fill::zeros);
+  
+  for (unsigned int j = 0; j < n_chunk_rows; j++) {
+    unsigned int begin = basis_t.col_ptrs[j];
+    unsigned int end   = basis_t.col_ptrs[j + 1];
+    
+    // Rows without non zero entries (e.g. outside of the knot range):
+    if (begin == end) { continue; }
+    
+    uint32_t start = basis_t.row_indices[begin];
+    if (basis_t.row_indices[end - 1] - start >= band_width) {
+      Rcpp::stop("Row " + std::to_string(n_rows + j + 1) + " of the design matrix exceeds the band width " + std::to_string(band_width) + ".");
+    }
+    if (start + band_width > n_cols) {
+      start = n_cols - band_width;
+    }
+    band_start[j] = start;
+    for (unsigned int k = begin; k < end; k++) {
+      band_values(basis_t.row_indices[k] - start, j) = basis_t.values[k];
+    }
+  }
+  chunk_offsets.push_back(chunk_writer.tellp());
+  chunk_first_row.push_back(n_rows);
+  
+  serialize::writeUInt(chunk_writer, n_chunk_rows);
+  chunk_writer.write(reinterpret_cast<const char*>(band_start.data()), n_chunk_rows * sizeof(uint32_t));
+  chunk_writer.write(reinterpret_cast<const char*>(band_values.memptr()), band_values.n_elem * sizeof(double));
+  
+  if (! chunk_writer) {
+    Rcpp::stop("Could not write chunk into file '" + file_name + "'.");
+  }
+  n_rows += n_chunk_rows;
+}
+
+void ChunkedData::finishChunks ()
+{
+  chunk_writer.close();
+  if (! chunk_writer) {
+    Rcpp::stop("Could not write chunks into file '" + file_name + "'.");
+  }
+}
+
+// Read one chunk. This is called by the prefetch thread and therefore must
+// not use the R API (also not for errors):
+static void readChunk (std::ifstream& in, const uint64_t offset, const unsigned int first_row, 
+  const unsigned int band_width, DataChunk& chunk)
+{
+  uint64_t n_chunk_rows = 0;
+  
+  in.seekg(offset);
+  in.read(reinterpret_cast<char*>(&n_chunk_rows), sizeof(uint64_t));
+  if (! in) {
+    throw std::runtime_error("Could not read chunk of the design matrix.");
+  }
+  chunk.first_row = first_row;
+  chunk.band_start.resize(n_chunk_rows);
+  chunk.band_values.set_size(band_width, n_chunk_rows);
+  
+  in.read(reinterpret_cast<char*>(chunk.band_start.data()), n_chunk_rows * sizeof(uint32_t));
+  in.read(reinterpret_cast<char*>(chunk.band_values.memptr()), chunk.band_values.n_elem * sizeof(double));
+  if (! in) {
+    throw std::runtime_error("Could not read chunk of the design matrix.");
+  }
+}
+
+/**
+ * \brief Call a function for every chunk with double-buffering
+ * 
+ * One reader thread reads the chunks in order into two buffers. While `fun`
+ * processes chunk `i`, chunk `i + 1` is read into the second buffer, the
+ * reader waits until a buffer is free again. Hence, not more than two chunks
+ * are in memory and just one thread is started per call. The functions which
+ * stream the chunks are also called within the training, which can run in a
+ * background thread. Hence, errors are thrown as `std::exception` instead of
+ * using `Rcpp::stop`.
+ * 
+ * \param fun `std::function` which is called with each chunk in order
+ */
+void ChunkedData::forEachChunk (const std::function<void (const DataChunk&)>& fun) const
+{
+  if (chunk_writer.is_open()) {
+    throw std::runtime_error("The chunks of file '" + file_name + "' are not finished yet.");
+  }
+  const unsigned int n_chunks = chunk_offsets.size();
+  if (n_chunks == 0) { return; }
+  
+  std::ifstream in (file_name.c_str(), std::ios::in | std::ios::binary);
+  if (! in.is_open()) {
+    throw std::runtime_error("Could not open file '" + file_name + "' for reading.");
+  }
+  DataChunk buffers[2];
+  
+  // Number of chunks which are read and which are processed by `fun`:
+  std::mutex chunk_mutex;
+  std::condition_variable chunk_condition;
+  unsigned int n_read = 0;
+  unsigned int n_processed = 0;
+  bool stop_reading = false;
+  std::exception_ptr read_error = NULL;
+  
+  std::thread reader([&] () {
+    try {
+      for (unsigned int i = 0; i < n_chunks; i++) {
+        {
+          std::unique_lock<std::mutex> lock (chunk_mutex);
+          chunk_condition.wait(lock, [&] () { return i < n_processed + 2 || stop_reading; });
+          if (stop_reading) { return; }
+        }
+        readChunk(in, chunk_offsets[i], chunk_first_row[i], band_width, buffers[i % 2]);
+        {
+          std::lock_guard<std::mutex> lock (chunk_mutex);
+          n_read = i + 1;
+        }
+        chunk_condition.notify_all();
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock (chunk_mutex);
+      read_error = std::current_exception();
+      chunk_condition.notify_all();
+    }
+  });
+  
+  std::exception_ptr fun_error = NULL;
+  for (unsigned int i = 0; i < n_chunks; i++) {
+    {
+      std::unique_lock<std::mutex> lock (chunk_mutex);
+      chunk_condition.wait(lock, [&] () { return i < n_read || read_error; });
+      if (i >= n_read) { break; }
+    }
+    try {
+      fun(buffers[i % 2]);
+    } catch (...) {
+      fun_error = std::current_exception();
+      break;
+    }
+    {
+      std::lock_guard<std::mutex> lock (chunk_mutex);
+      n_processed = i + 1;
+    }
+    chunk_condition.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> lock (chunk_mutex);
+    stop_reading = true;
+  }
+  chunk_condition.notify_all();
+  reader.join();
+  
+  if (fun_error) { std::rethrow_exception(fun_error); }
+  if (read_error) { std::rethrow_exception(read_error); }
+}
+
+/**
+ * \brief Compute \f$X^T r\f$ by streaming the chunks
+ * 
+ * \param response `arma::vec` vector with one element per row
+ * 
+ * \returns `arma::vec` with one element per column
+ */
+arma::vec ChunkedData::crossprodChunks (const arma::vec& response) const
+{
+  if (response.n_elem != n_rows) {
+    throw std::runtime_error("The vector has " + std::to_string(response.n_elem) + " elements but the chunked data has " + std::to_string(n_rows) + " rows.");
+  }
+  arma::vec out (n_cols, arma::fill::zeros);
+  
+  forEachChunk([&out, &response, this] (const DataChunk& chunk) {
+    for (unsigned int j = 0; j < chunk.band_start.size(); j++) {
+      double response_j = response[chunk.first_row + j];
+      const double* values = chunk.band_values.colptr(j);
+      
+      for (unsigned int b = 0; b < band_width; b++) {
+        out[chunk.band_start[j] + b] += values[b] * response_j;
+      }
+    }
+  });
+  return out;
+}
+
+/**
+ * \brief Compute \f$X b\f$ by streaming the chunks
+ * 
+ * \param parameter `arma::vec` vector with one element per column
+ * 
+ * \returns `arma::vec` with one element per row
+ */
+arma::vec ChunkedData::multiplyChunks (const arma::vec& parameter) const
+{
+  if (parameter.n_elem != n_cols) {
+    throw std::runtime_error("The vector has " + std::to_string(parameter.n_elem) + " elements but the chunked data has " + std::to_string(n_cols) + " columns.");
+  }
+  arma::vec out (n_rows);
+  
+  forEachChunk([&out, &parameter, this] (const DataChunk& chunk) {
+    for (unsigned int j = 0; j < chunk.band_start.size(); j++) {
+      const double* values = chunk.band_values.colptr(j);
+      const double* parameter_band = parameter.memptr() + chunk.band_start[j];
+      
+      double sum = 0;
+      for (unsigned int b = 0; b < band_width; b++) {
+        sum += values[b] * parameter_band[b];
+      }
+      out[chunk.first_row + j] = sum;
+    }
+  });
+  return out;
+}
+
+std::string ChunkedData::getFileName () const
+{
+  return file_name;
+}
+
+unsigned int ChunkedData::getChunkSize () const
+{
+  return chunk_size;
+}
+
+unsigned int ChunkedData::getNumberOfChunks () const
+{
+  return chunk_offsets.size();
+}
+
+ChunkedData::~ChunkedData ()
+{
+  if (chunk_writer.is_open()) {
+    chunk_writer.close();
+  }
+  if (chunk_offsets.size() > 0) {
+    std::remove(file_name.c_str());
+  }
+}
+
 } // namespace data
@@ -37,6 +37,11 @@
 #define DATA_H_
 
 #include "RcppArmadillo.h"
+#include "serialize.h"
+
+#include <vector>
+#include <fstream>
+#include <functional>
 
 namespace data 
 {
@@ -52,6 +57,21 @@ protected:
   std::string data_identifier = "";
   std::string data_type = "ordinary";
   
+  // Description of the factory and raw data the target was prepared for. If
+  // a factory finds its own tag, the preparation is skipped:
+  std::string preparation_tag = "";
+  
+  // Opt-in to store the design matrix of a target in single precision:
+  bool use_single_precision = false;
+  
+  // Number of bins if the feature of a target is binned (0 means no binning):
+  unsigned int n_bins = 0;
+  
+  // Flag if a factory uses this object as target. A flag instead of a count
+  // since factories and targets are freed by the garbage collector of `R` in
+  // any order:
+  bool used_by_factory = false;
+  
 public:
   
   // Declare the data stuff public that every class can access the data 
@@ -68,14 +88,26 @@ public:
   /// Sparse matrix for design matrix (directly accessible)
   arma::sp_mat sparse_data_mat;
   
+  /// Single precision design matrices which replace `data_mat` and 
+  /// `sparse_data_mat` after `convertToSinglePrecision()`
+  arma::fmat data_mat_float;
+  arma::sp_fmat sparse_data_mat_float;
+  
+  /// Bin of each observation, number of observations per bin, and the design
+  /// matrix with one row per bin which replace the design matrix if binned
+  std::vector<uint16_t> bin_idx;
+  arma::vec bin_counts;
+  arma::mat bin_data_mat;
+  
   
   const arma::mat* data_mat_ptr = NULL;
   
   // Some spline specific data stuff (of course they can be used for other
   // classes to):
   
-  /// Penalty matrix (directly accessible)
-  arma::mat penalty_mat;
+  /// Cross product \f$X^T X\f$ of the design matrix (directly accessible).
+  /// Factories which share the target add their own penalty to it
+  arma::mat XtX;
   
   /// Vector of knots (directly accessible)
   arma::vec knots;
@@ -97,11 +129,57 @@ public:
   /// Get the design matrix 
   virtual arma::mat getData () const = 0;
   
+  /// Raw data of a source (in memory or mapped) without copying it
+  const arma::mat& getSourceData () const;
+  
   void setDataIdentifier (const std::string&);
   std::string getDataIdentifier () const;
   
   void setDataType (const std::string&);
   
+  void setPreparationTag (const std::string&);
+  std::string getPreparationTag () const;
+  
+  /// Targets are shared by factories with the same transformation and are 
+  /// immutable as soon as one factory uses them
+  void markAsUsedByFactory ();
+  bool isUsedByFactory () const;
+  void checkPreparation (const std::string&) const;
+  
+  /// Store and restore prepared target data (basis, knots, penalty, ...)
+  void saveData (const std::string&) const;
+  void loadData (const std::string&);
+  
+  /// Tag if the design matrix is stored in row chunks on disk (see `ChunkedData`)
+  virtual bool isChunked () const;
+  
+  /// Store the design matrix of a target as float, sums are still computed in double
+  void setSinglePrecision (const bool&);
+  bool usesSinglePrecision () const;
+  bool hasSinglePrecisionData () const;
+  void convertToSinglePrecision ();
+  
+  /// Bytes of the values of the stored design matrix (without sparse indices)
+  unsigned int getDesignBytes () const;
+  
+  /// \f$X^T r\f$ and \f$X b\f$ with the single precision design matrix
+  arma::vec crossprodSinglePrecision (const arma::vec&) const;
+  arma::vec multiplySinglePrecision (const arma::vec&) const;
+  
+  /// Quantize the feature of a target into bins and compute the design matrix per bin
+  void setBinning (const unsigned int&);
+  unsigned int getNumberOfBins () const;
+  bool hasBinnedData () const;
+  arma::vec createBins (const arma::mat&);
+  
+  /// Sums of a vector per bin and expansion of values per bin to all observations
+  arma::vec sumPerBin (const arma::vec&) const;
+  arma::vec expandBins (const arma::vec&) const;
+  
+  /// \f$X^T r\f$ and \f$X b\f$ with the binned design matrix
+  arma::vec crossprodBins (const arma::vec&) const;
+  arma::vec multiplyBins (const arma::vec&) const;
+  
   virtual 
     ~Data () { };
 };
@@ -137,6 +215,114 @@ public:
   
 };
 
+// MappedData:
+// -----------------------
+
+// Read only source data which maps one column of a binary file into memory.
+// The file contains the raw doubles of a matrix in column-major order (e.g. 
+// written by `writeBin()` in R). Just the pages which are accessed are loaded
+// by the operating system, hence the file can be much larger than the RAM.
+
+class MappedData : public Data
+{
+private:
+  
+  std::string file_name;
+  unsigned int n_rows;
+  unsigned int column;
+  
+  // Page aligned mapped region and its length:
+  void* mapped_region = NULL;
+  std::size_t mapped_length = 0;
+  
+  // Matrix which uses the mapped memory without copying it:
+  arma::mat mapped_mat;
+  
+public:
+  
+  // Map column of a file with a given number of rows:
+  MappedData (const std::string&, const unsigned int&, const unsigned int&, const std::string&);
+  
+  void setData (const arma::mat&);
+  arma::mat getData() const;
+  
+  std::string getFileName () const;
+  unsigned int getColumn () const;
+  
+  ~MappedData ();
+  
+};
+
+// ChunkedData:
+// -----------------------
+
+// Target data which stores a banded design matrix in row chunks on disk. In
+// a banded matrix every row has at most `band_width` consecutive non zero
+// entries, e.g. a B-spline basis has `degree + 1` of them. A row is stored
+// as the index of its first column and the band of values. Training streams
+// the chunks to compute X^T r and X b. The next chunk is read by another 
+// thread while the current one is processed (double-buffering), hence just 
+// two chunks are in memory at the same time.
+
+struct DataChunk
+{
+  unsigned int first_row = 0;
+  std::vector<uint32_t> band_start;
+  arma::mat band_values;
+};
+
+class ChunkedData : public Data
+{
+private:
+  
+  std::string file_name;
+  unsigned int chunk_size;
+  
+  unsigned int n_rows = 0;
+  unsigned int n_cols = 0;
+  unsigned int band_width = 0;
+  
+  // Position of each chunk within the file and its first row:
+  std::vector<uint64_t> chunk_offsets;
+  std::vector<unsigned int> chunk_first_row;
+  
+  std::ofstream chunk_writer;
+  
+  // Call a function for every chunk while the next one is read:
+  void forEachChunk (const std::function<void (const DataChunk&)>&) const;
+  
+public:
+  
+  // File which stores the chunks and the number of rows per chunk:
+  ChunkedData (const std::string&, const unsigned int&);
+  
+  void setData (const arma::mat&);
+  
+  // Read all chunks into a dense matrix (just meant for small data):
+  arma::mat getData () const;
+  
+  bool isChunked () const;
+  
+  // Write the transposed design matrix (one column per observation) chunk
+  // by chunk, the arguments of startChunks are the number of columns and 
+  // the band width:
+  void startChunks (const unsigned int&, const unsigned int&);
+  void appendChunk (const arma::sp_mat&);
+  void finishChunks ();
+  
+  // Stream the chunks to compute X^T r and X b:
+  arma::vec crossprodChunks (const arma::vec&) const;
+  arma::vec multiplyChunks (const arma::vec&) const;
+  
+  std::string getFileName () const;
+  unsigned int getChunkSize () const;
+  unsigned int getNumberOfChunks () const;
+  
+  // Removes the file:
+  ~ChunkedData ();
+  
+};
+
 } // namespace data
 
 #endif // DATA_H_
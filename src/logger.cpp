@@ -52,9 +52,107 @@ bool Logger::getIfLoggerIsStopper () const
   return is_a_stopper;
 }
 
+/**
+ * \brief Tag if the logger calls `R` functions
+ * 
+ * Logger which call `R` functions can't be used outside of the main thread, 
+ * e.g. for asynchronous training.
+ * 
+ * \returns `bool` which is `false` by default
+ */
+bool Logger::usesRFunctions () const
+{
+  return false;
+}
+
 // Destructor:
 Logger::~Logger () { }
 
+// The state of each logger starts with its type to recognize checkpoints 
+// which were written with another logger of the same name:
+static void writeLoggerType (std::ostream& out, const std::string& logger_type)
+{
+  serialize::writeString(out, logger_type);
+}
+
+static void readLoggerType (std::istream& in, const std::string& logger_type)
+{
+  std::string saved_type = serialize::readString(in);
+  if (saved_type != logger_type) {
+    Rcpp::stop("The logger state was written by a '" + saved_type + "' logger and can't be restored into a '" + logger_type + "' logger.");
+  }
+}
+
+/**
+ * \brief Draw a sorted random subsample of row indices
+ * 
+ * The subsample is drawn without replacement by a partial Fisher-Yates 
+ * shuffle. Since the seed is fixed, the same rows are used in every 
+ * iteration which makes the risk of different iterations comparable.
+ * 
+ * \param n `unsigned int` number of rows
+ * \param fraction `double` fraction of rows to draw, the subsample contains
+ *   at least one row
+ * \param seed `unsigned int` seed of the random number generator
+ * 
+ * \returns `arma::uvec` of sorted row indices
+ */
+arma::uvec drawSubsampleIndices (const unsigned int& n, const double& fraction, 
+  const unsigned int& seed)
+{
+  unsigned int n_sub = std::ceil(fraction * n);
+  if (n_sub < 1) { n_sub = 1; }
+  if (n_sub > n) { n_sub = n; }
+  
+  std::mt19937 rng (seed);
+  std::vector<unsigned int> idx (n);
+  for (unsigned int i = 0; i < n; i++) { idx[i] = i; }
+  
+  // The modulo of the generator draws the same rows with every standard 
+  // library (the distributions of <random> are implementation defined):
+  for (unsigned int i = 0; i < n_sub; i++) {
+    unsigned int j = i + rng() % (n - i);
+    std::swap(idx[i], idx[j]);
+  }
+  arma::uvec out (n_sub);
+  for (unsigned int i = 0; i < n_sub; i++) { out(i) = idx[i]; }
+  
+  return arma::sort(out);
+}
+
+/**
+ * \brief Average relative improvement per iteration over a moving window
+ * 
+ * For the evaluated risks \f$\mathcal{R}_1, \dots, \mathcal{R}_k\f$ at the
+ * iterations \f$m_1, \dots, m_k\f$ and a window of \f$w\f$ evaluations the 
+ * relative improvement is
+ * \f[
+ *   \varepsilon = \frac{\mathcal{R}_{k-w} - \mathcal{R}_k}{\mathcal{R}_{k-w}} \frac{1}{m_k - m_{k-w}}.
+ * \f]
+ * Compared to the improvement of two consecutive evaluations, the window 
+ * smooths single iterations with (almost) no improvement which otherwise 
+ * stop the algorithm too early.
+ * 
+ * \param risk `std::vector<double>` evaluated risks
+ * \param iteration `std::vector<unsigned int>` iterations of the evaluations
+ * \param window `unsigned int` number of evaluations of the window
+ * 
+ * \returns `double` relative improvement or infinity if there are not enough
+ *   evaluations to fill the window
+ */
+double relativeImprovement (const std::vector<double>& risk, 
+  const std::vector<unsigned int>& iteration, const unsigned int& window)
+{
+  unsigned int n_evaluated = risk.size();
+  if (n_evaluated <= window) {
+    return arma::datum::inf;
+  }
+  double risk_start = risk[n_evaluated - 1 - window];
+  double eps = (risk_start - risk[n_evaluated - 1]) / risk_start;
+  
+  return eps / (iteration[n_evaluated - 1] - iteration[n_evaluated - 1 - window]);
+}
+
 
 
 
@@ -97,12 +195,14 @@ LoggerIteration::LoggerIteration (const bool& is_a_stopper0,
  *   iteration `current_iteration`
  * \param offset `double` of the overall offset of the training
  * \param learning_rate `double` lerning rate of the `current_iteration`
+ * \param momentum `double` momentum of the `current_iteration` (accelerated
+ *   training)
  * 
  */
 
 void LoggerIteration::logStep (const unsigned int& current_iteration, const arma::vec& response, 
   const arma::vec& prediction, blearner::Baselearner* used_blearner, const double& offset, 
-  const double& learning_rate)
+  const double& learning_rate, const double& momentum)
 {
   iterations.push_back(current_iteration);
 }
@@ -181,6 +281,18 @@ std::string LoggerIteration::printLoggerStatus () const
   return ss.str();
 }
 
+void LoggerIteration::saveLoggerState (std::ostream& out) const
+{
+  writeLoggerType(out, "iteration");
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(iterations));
+}
+
+void LoggerIteration::loadLoggerState (std::istream& in)
+{
+  readLoggerType(in, "iteration");
+  iterations = arma::conv_to<std::vector<unsigned int>>::from(serialize::readMat(in));
+}
+
 
 
 
@@ -205,6 +317,44 @@ LoggerInbagRisk::LoggerInbagRisk (const bool& is_a_stopper0, loss::Loss* used_lo
   is_a_stopper = is_a_stopper0;
 }
 
+/**
+ * \brief Constructor of class `LoggerInbagRisk` for strided and subsampled logging
+ * 
+ * Evaluating the risk on all rows in every iteration can dominate the runtime
+ * of long runs. This constructor allows to evaluate the risk just every 
+ * `log_every` iteration and on a fixed random subsample of the rows. The 
+ * seed of the subsample comes from the `R` random number generator, hence 
+ * `set.seed()` makes it reproducible.
+ * 
+ * \param is_a_stopper0 `bool` specify if the logger should be used as stopper
+ * \param used_loss `Loss*` used loss to calculate the empirical risk (this 
+ *   can differ from the one used while training the model)
+ * \param eps_for_break `double` sets value of the stopping criteria
+ * \param log_every `unsigned int` evaluate the risk every `log_every` iteration
+ * \param row_fraction `double` fraction of rows in \f$(0, 1]\f$ used to 
+ *   evaluate the risk
+ */
+LoggerInbagRisk::LoggerInbagRisk (const bool& is_a_stopper0, loss::Loss* used_loss, 
+  const double& eps_for_break, const unsigned int& log_every, const double& row_fraction)
+  : used_loss ( used_loss ),
+    eps_for_break ( eps_for_break ),
+    log_every ( log_every ),
+    row_fraction ( row_fraction )
+{
+  if (log_every < 1) {
+    Rcpp::stop("The risk must be logged at least every iteration (log_every >= 1).");
+  }
+  if ((row_fraction <= 0) || (row_fraction > 1)) {
+    Rcpp::stop("The fraction of rows used for logging must be in (0, 1].");
+  }
+  is_a_stopper = is_a_stopper0;
+  
+  if (row_fraction < 1) {
+    Rcpp::RNGScope scope;
+    subsample_seed = static_cast<unsigned int>(R::unif_rand() * 4294967295.0);
+  }
+}
+
 /**
  * \brief Log current step of compboost iteration for class `LoggerInbagRisk`
  * 
@@ -238,21 +388,41 @@ LoggerInbagRisk::LoggerInbagRisk (const bool& is_a_stopper0, loss::Loss* used_lo
  *   iteration `current_iteration`
  * \param offset `double` of the overall offset of the training
  * \param learning_rate `double` lerning rate of the `current_iteration`
+ * \param momentum `double` momentum of the `current_iteration` (accelerated
+ *   training)
  * 
  */
 
 void LoggerInbagRisk::logStep (const unsigned int& current_iteration, const arma::vec& response, 
   const arma::vec& prediction, blearner::Baselearner* used_blearner, const double& offset, 
-  const double& learning_rate)
+  const double& learning_rate, const double& momentum)
 {
+  // Skipped iterations are logged as NaN to keep all logger of the same length:
+  if ((current_iteration - 1) % log_every != 0) {
+    tracked_inbag_risk.push_back(arma::datum::nan);
+    return;
+  }
+  
   // Calculate empirical risk. Calculateion of the temporary vector ensures
   // // that stuff like auc logging is possible:
   // arma::vec loss_vec_temp = used_loss->definedLoss(response, prediction);
   // double temp_risk = arma::accu(loss_vec_temp) / loss_vec_temp.size();
 
-  double temp_risk = arma::mean(used_loss->definedLoss(response, prediction));
+  double temp_risk;
+  if (row_fraction < 1) {
+    if (subsample_idx.n_elem == 0) {
+      subsample_idx = drawSubsampleIndices(response.n_elem, row_fraction, subsample_seed);
+    }
+    arma::vec response_sub = response.elem(subsample_idx);
+    arma::vec prediction_sub = prediction.elem(subsample_idx);
+    temp_risk = used_loss->calculateEmpiricalRisk(response_sub, prediction_sub);
+  } else {
+    temp_risk = used_loss->calculateEmpiricalRisk(response, prediction);
+  }
   
   tracked_inbag_risk.push_back(temp_risk);
+  evaluated_risk.push_back(temp_risk);
+  evaluated_iteration.push_back(current_iteration);
 }
 
 /**
@@ -267,6 +437,12 @@ void LoggerInbagRisk::logStep (const unsigned int& current_iteration, const arma
  * 
  * The logger stops the algorithm if \f$\varepsilon^{[m]} \leq \varepsilon\f$.
  * 
+ * If the risk is just evaluated every \f$s\f$-th iteration, the relative 
+ * improvement between the last two evaluations \f$m - s\f$ and \f$m\f$ is
+ * divided by \f$s\f$ to get the average relative improvement per iteration.
+ * For \f$s = 1\f$ this equals the criteria above. To detect a plateau, the
+ * improvement can also be taken over the last `plateau_window` evaluations.
+ * 
  * \returns `bool` which tells if the stopping criteria is reached or not 
  *   (if the logger isn't a stopper then this is always false)
  */
@@ -276,21 +452,32 @@ bool LoggerInbagRisk::reachedStopCriteria () const
   bool stop_criteria_is_reached = false;
   
   if (is_a_stopper) {
-    if (tracked_inbag_risk.size() > 1) {
-      // We need to subtract -2 and -1 since c++ start counting by 0 while size
-      // returns the actual number of elements, so if just one element exists
-      // size returns 1 but we want to access 0:
-      double inbag_eps = tracked_inbag_risk[tracked_inbag_risk.size() - 2] - tracked_inbag_risk[tracked_inbag_risk.size() - 1];
-      inbag_eps = inbag_eps / tracked_inbag_risk[tracked_inbag_risk.size() - 2];
-      
-      if (inbag_eps <= eps_for_break) {
-        stop_criteria_is_reached = true;
-      }
+    double inbag_eps = relativeImprovement(evaluated_risk, evaluated_iteration, plateau_window);
+    if (inbag_eps <= eps_for_break) {
+      stop_criteria_is_reached = true;
     }
   }
   return stop_criteria_is_reached;
 }
 
+/**
+ * \brief Set the number of evaluations of the stopping window
+ * 
+ * With a window of \f$w\f$ evaluations, the algorithm stops if the average
+ * relative improvement of the last \f$w\f$ evaluations falls below 
+ * `eps_for_break` (see `relativeImprovement()`). The default \f$w = 1\f$ 
+ * compares the last two evaluations.
+ * 
+ * \param plateau_window `unsigned int` number of evaluations of the window
+ */
+void LoggerInbagRisk::setPlateauWindow (const unsigned int& plateau_window)
+{
+  if (plateau_window < 1) {
+    Rcpp::stop("The plateau window must contain at least one evaluation.");
+  }
+  this->plateau_window = plateau_window;
+}
+
 /**
  * \brief Return the data stored within the OOB risk logger
  * 
@@ -316,6 +503,8 @@ arma::vec LoggerInbagRisk::getLoggedData () const
 void LoggerInbagRisk::clearLoggerData ()
 {
   tracked_inbag_risk.clear();
+  evaluated_risk.clear();
+  evaluated_iteration.clear();
 }
 
 /**
@@ -331,11 +520,45 @@ void LoggerInbagRisk::clearLoggerData ()
 std::string LoggerInbagRisk::printLoggerStatus () const
 {
   std::stringstream ss;
-  ss << std::setw(17) << std::fixed << std::setprecision(2) << tracked_inbag_risk.back();
+  ss << std::setw(17) << std::fixed << std::setprecision(2) << evaluated_risk.back();
   
   return ss.str();
 }
 
+bool LoggerInbagRisk::usesRFunctions () const
+{
+  return used_loss->usesRFunctions();
+}
+
+/**
+ * \brief Write the logged risk
+ * 
+ * Besides the logged data, the seed of the row subsample is stored. Hence, 
+ * the restored logger evaluates the risk on the same rows.
+ * 
+ * \param out `std::ostream` stream to write to
+ */
+void LoggerInbagRisk::saveLoggerState (std::ostream& out) const
+{
+  writeLoggerType(out, "inbag.risk");
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(tracked_inbag_risk));
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(evaluated_risk));
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(evaluated_iteration));
+  serialize::writeUInt(out, subsample_seed);
+}
+
+void LoggerInbagRisk::loadLoggerState (std::istream& in)
+{
+  readLoggerType(in, "inbag.risk");
+  tracked_inbag_risk  = arma::conv_to<std::vector<double>>::from(serialize::readMat(in));
+  evaluated_risk      = arma::conv_to<std::vector<double>>::from(serialize::readMat(in));
+  evaluated_iteration = arma::conv_to<std::vector<unsigned int>>::from(serialize::readMat(in));
+  subsample_seed      = serialize::readUInt(in);
+  
+  // The subsample is drawn again from the restored seed:
+  subsample_idx.reset();
+}
+
 
 
 
@@ -369,6 +592,63 @@ LoggerOobRisk::LoggerOobRisk (const bool& is_a_stopper0, loss::Loss* used_loss,
   oob_prediction = temp;
 }
 
+/**
+ * \brief Constructor of `LoggerOobRisk` for strided and subsampled logging
+ * 
+ * The risk is just evaluated every `log_every` iteration. If `row_fraction`
+ * is smaller than one, the OOB data and response are reduced once to a random 
+ * subsample of the rows. The seed comes from the `R` random number generator, 
+ * hence `set.seed()` makes the subsample reproducible. Since the OOB 
+ * prediction has to be updated in every iteration, the subsample also 
+ * reduces the costs of these updates.
+ * 
+ * \param is_a_stopper0 `bool` to set if the logger should be used as stopper
+ * \param used_loss `Loss*` which is used to calculate the empirical risk (this 
+ *   can differ from the loss used while trining the model)
+ * \param eps_for_break `double` sets value of the stopping criteria
+ * \param oob_data `std::map<std::string, data::Data*>` the new data
+ * \param oob_response `arma::vec` response of the new data
+ * \param log_every `unsigned int` evaluate the risk every `log_every` iteration
+ * \param row_fraction `double` fraction of rows in \f$(0, 1]\f$ used to 
+ *   evaluate the risk
+ */
+LoggerOobRisk::LoggerOobRisk (const bool& is_a_stopper0, loss::Loss* used_loss, 
+  const double& eps_for_break, std::map<std::string, data::Data*> oob_data, 
+  const arma::vec& oob_response, const unsigned int& log_every, const double& row_fraction)
+  : used_loss ( used_loss ),
+    eps_for_break ( eps_for_break ),
+    oob_data ( oob_data ),
+    oob_response ( oob_response ),
+    log_every ( log_every )
+{
+  if (log_every < 1) {
+    Rcpp::stop("The risk must be logged at least every iteration (log_every >= 1).");
+  }
+  if ((row_fraction <= 0) || (row_fraction > 1)) {
+    Rcpp::stop("The fraction of rows used for logging must be in (0, 1].");
+  }
+  is_a_stopper = is_a_stopper0;
+  
+  if (row_fraction < 1) {
+    Rcpp::RNGScope scope;
+    unsigned int seed = static_cast<unsigned int>(R::unif_rand() * 4294967295.0);
+    arma::uvec idx = drawSubsampleIndices(oob_response.n_elem, row_fraction, seed);
+    
+    this->oob_response = oob_response.elem(idx);
+    for (auto& it : this->oob_data) {
+      // The data source constructor just stores a pointer, hence the subsample
+      // is stored as data matrix of the new object:
+      data::Data* oob_data_sub = new data::InMemoryData ();
+      oob_data_sub->setDataIdentifier(it.second->getDataIdentifier());
+      oob_data_sub->setData(it.second->getSourceData().rows(idx));
+      oob_data_subsample.push_back(oob_data_sub);
+      it.second = oob_data_sub;
+    }
+  }
+  arma::vec temp (this->oob_response.size());
+  oob_prediction = temp;
+}
+
 /**
  * \brief Log current step of compboost iteration for class `LoggerOobRisk`
  * 
@@ -403,34 +683,59 @@ LoggerOobRisk::LoggerOobRisk (const bool& is_a_stopper0, loss::Loss* used_loss,
  *   iteration `current_iteration`
  * \param offset `double` of the overall offset of the training
  * \param learning_rate `double` lerning rate of the `current_iteration`
+ * \param momentum `double` momentum of the `current_iteration` (accelerated
+ *   training)
  * 
  */
 
 void LoggerOobRisk::logStep (const unsigned int& current_iteration, const arma::vec& response, 
   const arma::vec& prediction, blearner::Baselearner* used_blearner, const double& offset, 
-  const double& learning_rate)
+  const double& learning_rate, const double& momentum)
 {
   if (current_iteration == 1) {
     oob_prediction.fill(offset);
   }
   
-  // Get data of corresponding selected baselearner. E.g. iteration 100 linear 
-  // baselearner of feature x_7, then get the data of feature x_7:
-  data::Data* oob_blearner_data = oob_data.find(used_blearner->getDataIdentifier())->second;
+  // Get the transformed OOB data of the factory of the selected base-learner.
+  // The OOB data is transformed just once, the first time a base-learner of
+  // that factory is selected (e.g. the sparse spline basis of feature x_7):
+  std::string factory_id = used_blearner->getDataIdentifier() + "_" + used_blearner->getBaselearnerType();
+  std::map<std::string, data::Data*>::iterator it_target = oob_data_targets.find(factory_id);
+  
+  data::Data* oob_blearner_target;
+  if (it_target == oob_data_targets.end()) {
+    data::Data* oob_blearner_data = oob_data.find(used_blearner->getDataIdentifier())->second;
+    oob_blearner_target = used_blearner->instantiateDataTarget(oob_blearner_data);
+    oob_data_targets[factory_id] = oob_blearner_target;
+  } else {
+    oob_blearner_target = it_target->second;
+  }
   
   // Predict this data using the selected baselearner:
-  arma::vec temp_oob_prediction = used_blearner->predict(oob_blearner_data);
+  arma::vec temp_oob_prediction = used_blearner->predictDataTarget(oob_blearner_target);
   
-  // Cumulate prediction and shrink by learning rate:
-  oob_prediction += learning_rate * temp_oob_prediction;
+  // Cumulate prediction and shrink by learning rate. With momentum, the
+  // update of the last iteration is added too (see `Compboost::train()`):
+  if (momentum == 0) {
+    oob_update = learning_rate * temp_oob_prediction;
+  } else {
+    oob_update = momentum * oob_update + learning_rate * temp_oob_prediction;
+  }
+  oob_prediction += oob_update;
   
-  // Calculate empirical risk. Calculateion of the temporary vector ensures
-  // that stuff like auc logging is possible:
-  arma::mat loss_vec_temp = used_loss->definedLoss(oob_response, oob_prediction);
-  double temp_risk = arma::accu(loss_vec_temp) / loss_vec_temp.size();
+  // Skipped iterations are logged as NaN to keep all logger of the same length:
+  if ((current_iteration - 1) % log_every != 0) {
+    tracked_oob_risk.push_back(arma::datum::nan);
+    return;
+  }
+  
+  // Calculate empirical risk (fused for the pre-defined losses):
+  double temp_risk = used_loss->calculateEmpiricalRisk(oob_response, oob_prediction);
   
   // Track empirical risk:
   tracked_oob_risk.push_back(temp_risk);
+  evaluated_risk.push_back(temp_risk);
+  evaluated_iteration.push_back(current_iteration);
 }
 
 /**
@@ -444,7 +749,13 @@ void LoggerOobRisk::logStep (const unsigned int& current_iteration, const arma::
  *   \varepsilon^{[m]} = \frac{\mathcal{R}_\mathrm{oob}^{[m-1]} - \mathcal{R}_\mathrm{oob}^{[m]}}{\mathcal{R}_\mathrm{oob}^{[m-1]}}.
  * \f]
  * 
- * The logger stops the algorithm if \f$\varepsilon^{[m]} \leq \varepsilon\f$
+ * The logger stops the algorithm if \f$\varepsilon^{[m]} \leq \varepsilon\f$.
+ * 
+ * If the risk is just evaluated every \f$s\f$-th iteration, the relative 
+ * improvement between the last two evaluations \f$m - s\f$ and \f$m\f$ is
+ * divided by \f$s\f$ to get the average relative improvement per iteration.
+ * For \f$s = 1\f$ this equals the criteria above. To detect a plateau, the
+ * improvement can also be taken over the last `plateau_window` evaluations.
  * 
  * \returns `bool` which tells if the stopping criteria is reached or not 
  *   (if the logger isn't a stopper then this is always false)
@@ -455,21 +766,32 @@ bool LoggerOobRisk::reachedStopCriteria () const
   bool stop_criteria_is_reached = false;
   
   if (is_a_stopper) {
-    if (tracked_oob_risk.size() > 1) {
-      // We need to subtract -2 and -1 since c++ start counting by 0 while size
-      // returns the actual number of elements, so if just one element exists
-      // size returns 1 but we want to access 0:
-      double oob_eps = tracked_oob_risk[tracked_oob_risk.size() - 2] - tracked_oob_risk[tracked_oob_risk.size() - 1];
-      oob_eps = oob_eps / tracked_oob_risk[tracked_oob_risk.size() - 2];
-      
-      if (oob_eps <= eps_for_break) {
-        stop_criteria_is_reached = true;
-      }
+    double oob_eps = relativeImprovement(evaluated_risk, evaluated_iteration, plateau_window);
+    if (oob_eps <= eps_for_break) {
+      stop_criteria_is_reached = true;
     }
   }
   return stop_criteria_is_reached;
 }
 
+/**
+ * \brief Set the number of evaluations of the stopping window
+ * 
+ * With a window of \f$w\f$ evaluations, the algorithm stops if the average
+ * relative improvement of the last \f$w\f$ evaluations falls below 
+ * `eps_for_break` (see `relativeImprovement()`). The default \f$w = 1\f$ 
+ * compares the last two evaluations.
+ * 
+ * \param plateau_window `unsigned int` number of evaluations of the window
+ */
+void LoggerOobRisk::setPlateauWindow (const unsigned int& plateau_window)
+{
+  if (plateau_window < 1) {
+    Rcpp::stop("The plateau window must contain at least one evaluation.");
+  }
+  this->plateau_window = plateau_window;
+}
+
 /**
  * \brief Return the data stored within the OOB risk logger
  * 
@@ -494,6 +816,8 @@ arma::vec LoggerOobRisk::getLoggedData () const
 void LoggerOobRisk::clearLoggerData ()
 {
   tracked_oob_risk.clear();
+  evaluated_risk.clear();
+  evaluated_iteration.clear();
 }
 
 /**
@@ -509,11 +833,59 @@ void LoggerOobRisk::clearLoggerData ()
 std::string LoggerOobRisk::printLoggerStatus () const
 {
   std::stringstream ss;
-  ss << std::setw(17) << std::fixed << std::setprecision(2) << tracked_oob_risk.back();
+  ss << std::setw(17) << std::fixed << std::setprecision(2) << evaluated_risk.back();
   
   return ss.str();
 }
 
+bool LoggerOobRisk::usesRFunctions () const
+{
+  return used_loss->usesRFunctions();
+}
+
+/**
+ * \brief Write the logged risk and the current OOB prediction
+ * 
+ * The OOB prediction is updated in every iteration, therefore it is part of
+ * the state. Note that a subsample of the OOB data is drawn when the logger
+ * is created, hence the restored logger must be created with the same seed.
+ * 
+ * \param out `std::ostream` stream to write to
+ */
+void LoggerOobRisk::saveLoggerState (std::ostream& out) const
+{
+  writeLoggerType(out, "oob.risk");
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(tracked_oob_risk));
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(evaluated_risk));
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(evaluated_iteration));
+  serialize::writeMat(out, oob_prediction);
+}
+
+void LoggerOobRisk::loadLoggerState (std::istream& in)
+{
+  readLoggerType(in, "oob.risk");
+  tracked_oob_risk    = arma::conv_to<std::vector<double>>::from(serialize::readMat(in));
+  evaluated_risk      = arma::conv_to<std::vector<double>>::from(serialize::readMat(in));
+  evaluated_iteration = arma::conv_to<std::vector<unsigned int>>::from(serialize::readMat(in));
+  
+  arma::vec saved_prediction = serialize::readMat(in);
+  if (saved_prediction.n_elem != oob_response.n_elem) {
+    Rcpp::stop("The OOB prediction of the logger state doesn't match the OOB data.");
+  }
+  oob_prediction = saved_prediction;
+}
+
+/// Destructor, the transformed and subsampled OOB data is owned by the logger
+LoggerOobRisk::~LoggerOobRisk ()
+{
+  for (auto& it : oob_data_targets) {
+    delete it.second;
+  }
+  for (unsigned int i = 0; i < oob_data_subsample.size(); i++) {
+    delete oob_data_subsample[i];
+  }
+}
+
 
 
 
@@ -568,12 +940,14 @@ LoggerTime::LoggerTime (const bool& is_a_stopper0, const unsigned int& max_time,
  *   iteration `current_iteration`
  * \param offset `double` of the overall offset of the training
  * \param learning_rate `double` lerning rate of the `current_iteration`
+ * \param momentum `double` momentum of the `current_iteration` (accelerated
+ *   training)
  * 
  */
 
 void LoggerTime::logStep (const unsigned int& current_iteration, const arma::vec& response, 
   const arma::vec& prediction, blearner::Baselearner* used_blearner, const double& offset, 
-  const double& learning_rate)
+  const double& learning_rate, const double& momentum)
 {
   if (current_time.size() == 0) {
     init_time = std::chrono::steady_clock::now();
@@ -589,6 +963,28 @@ void LoggerTime::logStep (const unsigned int& current_iteration, const arma::vec
   }
 }
 
+/**
+ * \brief Elapsed time since `init_time` in `time_unit`
+ * 
+ * In contrast to the logged time, the elapsed time is not rounded down to
+ * whole units.
+ * 
+ * \returns `double` elapsed time
+ */
+
+double LoggerTime::elapsedTime () const
+{
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - init_time;
+  
+  if (time_unit == "minutes") {
+    return elapsed.count() / 60e6;
+  }
+  if (time_unit == "seconds") {
+    return elapsed.count() / 1e6;
+  }
+  return elapsed.count();
+}
+
 /**
  * \brief Stop criteria is fulfilled if the passed time exceeds `max_time`
  * 
@@ -598,6 +994,13 @@ void LoggerTime::logStep (const unsigned int& current_iteration, const arma::vec
  *   \mathrm{current_time}_m > \mathrm{max_time}
  * \f]
  * 
+ * With lookahead, the time \f$t\f$ of the next iteration is projected by the
+ * average time per iteration so far and the criteria is triggered if
+ * \f[
+ *   t_m + \frac{t_m}{m - 1} > \mathrm{max_time}.
+ * \f]
+ * Hence, the training stops before the budget is exceeded and not after.
+ * 
  * \returns `bool` which tells if the stopping criteria is reached or not 
  *   (if the logger isn't a stopper then this is always false)
  */
@@ -610,10 +1013,29 @@ bool LoggerTime::reachedStopCriteria () const
     if (current_time.back() >= max_time) {
       stop_criteria_is_reached = true;
     }
+    // The first log just sets the initial time:
+    if (use_lookahead && (current_time.size() > 1)) {
+      double elapsed = elapsedTime();
+      if (elapsed + elapsed / (current_time.size() - 1) > max_time) {
+        stop_criteria_is_reached = true;
+      }
+    }
   }
   return stop_criteria_is_reached;
 }
 
+/**
+ * \brief Project the time of the next iteration to stop within the time budget
+ * 
+ * \param use_lookahead `bool` stop if the next iteration is expected to 
+ *   exceed `max_time`
+ */
+
+void LoggerTime::setLookahead (const bool& use_lookahead)
+{
+  this->use_lookahead = use_lookahead;
+}
+
 /**
  * \brief Return the data stored within the time logger
  * 
@@ -666,4 +1088,30 @@ std::string LoggerTime::printLoggerStatus () const
   return ss.str();
 }
 
+void LoggerTime::saveLoggerState (std::ostream& out) const
+{
+  writeLoggerType(out, "time");
+  serialize::writeMat(out, arma::conv_to<arma::vec>::from(current_time));
+}
+
+// The elapsed time continues at the restored value:
+void LoggerTime::loadLoggerState (std::istream& in)
+{
+  readLoggerType(in, "time");
+  current_time = arma::conv_to<std::vector<unsigned int>>::from(serialize::readMat(in));
+  
+  if (current_time.size() > 0) {
+    init_time = std::chrono::steady_clock::now();
+    if (time_unit == "minutes") {
+      init_time -= std::chrono::minutes(current_time.back());
+    }
+    if (time_unit == "seconds") {
+      init_time -= std::chrono::seconds(current_time.back());
+    }
+    if (time_unit == "microseconds") {
+      init_time -= std::chrono::microseconds(current_time.back());
+    }
+  }
+}
+
 } // namespace logger
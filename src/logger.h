@@ -60,6 +60,7 @@
 #include <chrono>
 #include <iomanip> // ::setw
 #include <sstream> // ::stringstream
+#include <random>  // ::mt19937
 
 #include "loss.h"
 #include "baselearner.h"
@@ -93,7 +94,7 @@ public:
   
   /// Log current step of compboost iteration dependent on the child class
   virtual void logStep (const unsigned int&, const arma::vec&, const arma::vec&, 
-    blearner::Baselearner*, const double&, const double&) = 0;
+    blearner::Baselearner*, const double&, const double&, const double&) = 0;
   
   /// Class dependent check if the stopping criteria is fulfilled
   virtual bool reachedStopCriteria () const = 0;
@@ -110,6 +111,13 @@ public:
   /// Just a getter if the logger is also used as stopper
   bool getIfLoggerIsStopper () const;
   
+  /// Tag if the logger calls `R` functions (e.g. by using a custom loss)
+  virtual bool usesRFunctions () const;
+  
+  /// Write and restore the logged data (used for checkpoints)
+  virtual void saveLoggerState (std::ostream&) const = 0;
+  virtual void loadLoggerState (std::istream&) = 0;
+  
   virtual 
     ~Logger ();
   
@@ -119,6 +127,13 @@ protected:
   bool is_a_stopper;
 };
 
+/// Draw a sorted random subsample of `ceil(fraction * n)` row indices
+arma::uvec drawSubsampleIndices (const unsigned int&, const double&, const unsigned int&);
+
+/// Average relative improvement per iteration over the last `window` evaluated risks
+double relativeImprovement (const std::vector<double>&, const std::vector<unsigned int>&, 
+  const unsigned int&);
+
 // -------------------------------------------------------------------------- //
 // Logger implementations:
 // -------------------------------------------------------------------------- //
@@ -153,7 +168,7 @@ public:
   
   /// Log current step of compboost iteration of class `LoggerIteration`
   void logStep (const unsigned int&, const arma::vec&, const arma::vec&, 
-    blearner::Baselearner*, const double&, const double&);
+    blearner::Baselearner*, const double&, const double&, const double&);
   
   /// Stop criteria is fulfilled if the current iteration exceed `max_iteration`
   bool reachedStopCriteria () const;
@@ -166,6 +181,10 @@ public:
     
   /// Print status of current iteration into the console 
   std::string printLoggerStatus () const;
+  
+  /// Write and restore the logged data
+  void saveLoggerState (std::ostream&) const;
+  void loadLoggerState (std::istream&);
 };
 
 // InbagRisk:
@@ -196,19 +215,44 @@ private:
   /// Stopping criteria, stop if \f$(\mathrm{risk}_{i-1} - \mathrm{risk}_i) / \mathrm{risk}_{i-1} < \mathrm{eps\_for\_break}\f$
   double eps_for_break;
   
+  /// Evaluate the risk just every `log_every` iteration (others are logged as `NaN`)
+  unsigned int log_every = 1;
+  
+  /// Fraction of rows used to evaluate the risk
+  double row_fraction = 1;
+  
+  /// Seed used to draw the fixed row subsample
+  unsigned int subsample_seed = 0;
+  
+  /// Fixed row subsample, drawn at the first evaluation if `row_fraction < 1`
+  arma::uvec subsample_idx;
+  
+  /// Evaluated risks and the corresponding iterations (used for stopping)
+  std::vector<double> evaluated_risk;
+  std::vector<unsigned int> evaluated_iteration;
+  
+  /// Number of evaluations the relative improvement is calculated over (plateau detection)
+  unsigned int plateau_window = 1;
+  
   
 public:
   
   /// Default constructor
   LoggerInbagRisk (const bool&, loss::Loss*, const double&);
   
+  /// Constructor for strided and subsampled risk logging
+  LoggerInbagRisk (const bool&, loss::Loss*, const double&, const unsigned int&, const double&);
+  
   /// Log current step of compboost iteration for class `LoggerInbagRisk`
   void logStep (const unsigned int&, const arma::vec&, const arma::vec&, 
-    blearner::Baselearner*, const double&, const double&);
+    blearner::Baselearner*, const double&, const double&, const double&);
   
   /// Stop criteria is fulfilled if the relative improvement falls below `eps_for_break`
   bool reachedStopCriteria () const;
   
+  /// Set the number of evaluations of the window used by `relativeImprovement()`
+  void setPlateauWindow (const unsigned int&);
+  
   /// Return the data stored within the logger
   arma::vec getLoggedData () const;
   
@@ -218,6 +262,13 @@ public:
   /// Print status of current iteration into the console 
   std::string printLoggerStatus () const;
   
+  /// The logger calls `R` functions if the used loss does
+  bool usesRFunctions () const;
+  
+  /// Write and restore the logged data
+  void saveLoggerState (std::ostream&) const;
+  void loadLoggerState (std::istream&);
+  
 };
 
 // OobRisk:
@@ -251,12 +302,31 @@ private:
   /// OOB prediction which is internally done in every iteration
   arma::vec oob_prediction;
   
+  /// Update of the OOB prediction of the last iteration (used with momentum)
+  arma::vec oob_update;
+  
   /// The OOB data provided by the user
   std::map<std::string, data::Data*> oob_data;
   
+  /// OOB data transformed into the layout of the training data (one target per factory)
+  std::map<std::string, data::Data*> oob_data_targets;
+  
   /// The response variable which corresponds to the given OOB data
   arma::vec oob_response;
   
+  /// Evaluate the risk just every `log_every` iteration (others are logged as `NaN`)
+  unsigned int log_every = 1;
+  
+  /// Subsampled OOB data owned by the logger (empty if all rows are used)
+  std::vector<data::Data*> oob_data_subsample;
+  
+  /// Evaluated risks and the corresponding iterations (used for stopping)
+  std::vector<double> evaluated_risk;
+  std::vector<unsigned int> evaluated_iteration;
+  
+  /// Number of evaluations the relative improvement is calculated over (plateau detection)
+  unsigned int plateau_window = 1;
+  
   
 public:
   
@@ -264,13 +334,20 @@ public:
   LoggerOobRisk (const bool&, loss::Loss*, const double&, 
     std::map<std::string, data::Data*>, const arma::vec&);
   
+  /// Constructor for strided and subsampled risk logging
+  LoggerOobRisk (const bool&, loss::Loss*, const double&, 
+    std::map<std::string, data::Data*>, const arma::vec&, const unsigned int&, const double&);
+  
   /// Log current step of compboost iteration for class `LoggerOobRisk`
   void logStep (const unsigned int&, const arma::vec&, const arma::vec&, 
-    blearner::Baselearner*, const double&, const double&);
+    blearner::Baselearner*, const double&, const double&, const double&);
   
   /// Stop criteria is fulfilled if the relative improvement falls below `eps_for_break`
   bool reachedStopCriteria () const;
   
+  /// Set the number of evaluations of the window used by `relativeImprovement()`
+  void setPlateauWindow (const unsigned int&);
+  
   /// Return the data stored within the logger
   arma::vec getLoggedData () const;
   
@@ -280,6 +357,16 @@ public:
   /// Print status of current iteration into the console 
   std::string printLoggerStatus () const;
   
+  /// The logger calls `R` functions if the used loss does
+  bool usesRFunctions () const;
+  
+  /// Write and restore the logged data
+  void saveLoggerState (std::ostream&) const;
+  void loadLoggerState (std::istream&);
+  
+  /// Destructor, deletes the transformed and subsampled OOB data
+  ~LoggerOobRisk ();
+  
 };
 
 // LoggerTime:
@@ -315,6 +402,12 @@ private:
   /// The unit for time measuring, allowed are `minutes`, `seconds` and `microseconds` 
   std::string time_unit;
   
+  /// Stop already if the next iteration is expected to exceed `max_time`
+  bool use_lookahead = false;
+  
+  /// Elapsed time since `init_time` in `time_unit` (not rounded)
+  double elapsedTime () const;
+  
   
 public:
   
@@ -323,11 +416,14 @@ public:
   
   /// Log current step of compboost iteration for class `LoggerTime`
   void logStep (const unsigned int&, const arma::vec&, const arma::vec&, 
-    blearner::Baselearner*, const double&, const double&);
+    blearner::Baselearner*, const double&, const double&, const double&);
   
   /// Stop criteria is fulfilled if the passed time exceeds `max_time`
   bool reachedStopCriteria () const;
   
+  /// Project the time of the next iteration to stop within the time budget
+  void setLookahead (const bool&);
+  
   /// Return the data stored within the logger
   arma::vec getLoggedData () const;
   
@@ -337,6 +433,10 @@ public:
   /// Print status of current iteration into the console 
   std::string printLoggerStatus () const;
   
+  /// Write and restore the logged data
+  void saveLoggerState (std::ostream&) const;
+  void loadLoggerState (std::istream&);
+  
 };
 
 } // namespace logger
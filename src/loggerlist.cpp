@@ -112,7 +112,7 @@ std::pair<std::vector<std::string>, arma::mat> LoggerList::getLoggerData () cons
 
 void LoggerList::logCurrent (const unsigned int& current_iteration, const arma::vec& response, 
   const arma::vec& prediction, blearner::Baselearner* used_blearner, const double& offset,
-  const double& learning_rate)
+  const double& learning_rate, const double& momentum)
 {
   // Think about how to implement this the best way. I think the computations 
   // e.g. for the risk should be done within the logger object. If so, the
@@ -127,7 +127,7 @@ void LoggerList::logCurrent (const unsigned int& current_iteration, const arma::
   // data specified by initializing the logger list.
   for (logger_map::iterator it = log_list.begin(); it != log_list.end(); ++it) {
     it->second->logStep(current_iteration, response, prediction, used_blearner, 
-      offset, learning_rate);
+      offset, learning_rate, momentum);
   }
 }
 // Print logger:
@@ -155,6 +155,45 @@ void LoggerList::clearLoggerData ()
   }
 }
 
+// Check if any logger calls R functions:
+bool LoggerList::usesRFunctions () const
+{
+  for (auto& it : log_list) {
+    if (it.second->usesRFunctions()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Write the state of all logger, each one with its name:
+void LoggerList::saveLoggerState (std::ostream& out) const
+{
+  serialize::writeUInt(out, log_list.size());
+  for (auto& it : log_list) {
+    serialize::writeString(out, it.first);
+    it.second->saveLoggerState(out);
+  }
+}
+
+// Restore the state, the same logger must be registered:
+void LoggerList::loadLoggerState (std::istream& in)
+{
+  unsigned int n_logger = serialize::readUInt(in);
+  if (n_logger != log_list.size()) {
+    Rcpp::stop("The logger state contains " + std::to_string(n_logger) + " logger but " 
+      + std::to_string(log_list.size()) + " logger are registered.");
+  }
+  for (unsigned int i = 0; i < n_logger; i++) {
+    std::string logger_id = serialize::readString(in);
+    logger_map::iterator it = log_list.find(logger_id);
+    if (it == log_list.end()) {
+      Rcpp::stop("Logger '" + logger_id + "' of the logger state isn't registered.");
+    }
+    it->second->loadLoggerState(in);
+  }
+}
+
 // Destructor:
 LoggerList::~LoggerList ()
 {
@@ -83,7 +83,7 @@ public:
   // Log the current step (structure <iteration, actual time, actual risk>).
   // This is given to the instantiated logger:
   void logCurrent (const unsigned int&, const arma::vec&, const arma::vec&, 
-    blearner::Baselearner*, const double&, const double&);
+    blearner::Baselearner*, const double&, const double&, const double&);
    
   // Print the logger status:
   void printLoggerStatus (const double&) const;
@@ -91,6 +91,13 @@ public:
   // Clear the logger data (should be used in front of every compboost training):
   void clearLoggerData ();
   
+  // Check if any of the registered logger calls R functions:
+  bool usesRFunctions () const;
+  
+  // Write and restore the logged data of all logger (used for checkpoints):
+  void saveLoggerState (std::ostream&) const;
+  void loadLoggerState (std::istream&);
+  
   // Destructor:
   ~LoggerList ();
 };
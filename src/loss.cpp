@@ -41,6 +41,50 @@ namespace loss
 // Parent class:
 // -----------------------
 
+/**
+ * \brief Empirical risk of given true values and predictions
+ * 
+ * The default calculates the vector of losses and averages over it. This 
+ * ensures that it is possible to e.g. use the AUC or any arbitrary 
+ * performance measure which just returns one value. Child classes with an
+ * elementwise loss overwrite this function to compute the risk in one pass
+ * without allocating the temporary loss vector.
+ * 
+ * \param true_value `arma::vec` True value of the response
+ * \param prediction `arma::vec` Prediction of the true value
+ * 
+ * \returns `double` empirical risk
+ */
+double Loss::calculateEmpiricalRisk (const arma::vec& true_value, const arma::vec& prediction) const
+{
+  arma::vec loss_vec_temp = definedLoss(true_value, prediction);
+  return arma::accu(loss_vec_temp) / loss_vec_temp.size();
+}
+
+// By default the second derivative is not available (see `hasHessian()`):
+arma::vec Loss::definedHessian (const arma::vec& true_value, const arma::vec& prediction) const
+{
+  throw std::runtime_error("The loss doesn't provide the second derivative.");
+  return arma::vec();
+}
+
+bool Loss::hasHessian () const
+{
+  return false;
+}
+
+// By default a loss is implemented in C++:
+bool Loss::usesRFunctions () const
+{
+  return false;
+}
+
+// Losses without an own type (custom losses) use the identity as response:
+std::string Loss::getLossType () const
+{
+  return "custom";
+}
+
 Loss::~Loss () {
   // Rcpp::Rcout << "Call Loss Destructor" << std::endl;
 }
@@ -106,6 +150,27 @@ arma::vec LossQuadratic::definedGradient (const arma::vec& true_value, const arm
   return prediction - true_value;
 }
 
+/**
+ * \brief Definition of the second derivative of the loss function (see 
+ *   description of the class)
+ * 
+ * \param true_value `arma::vec` True value of the response
+ * \param prediction `arma::vec` Prediction of the true value
+ * 
+ * \returns `arma::vec` vector of elementwise application of the second 
+ *   derivative
+ */
+
+arma::vec LossQuadratic::definedHessian (const arma::vec& true_value, const arma::vec& prediction) const
+{
+  return arma::vec(true_value.n_elem, arma::fill::ones);
+}
+
+bool LossQuadratic::hasHessian () const
+{
+  return true;
+}
+
 /**
  * \brief Definition of the constant risk initialization (see description of the class)
  * 
@@ -132,6 +197,29 @@ arma::vec LossQuadratic::responseTransformation (const arma::vec& score) const
   return score;
 }
 
+/**
+ * \brief Fused computation of the empirical risk
+ * 
+ * \param true_value `arma::vec` True value of the response
+ * \param prediction `arma::vec` Prediction of the true value
+ * 
+ * \returns `double` mean of the elementwise losses
+ */
+double LossQuadratic::calculateEmpiricalRisk (const arma::vec& true_value, const arma::vec& prediction) const
+{
+  double risk = 0;
+  for (unsigned int i = 0; i < true_value.n_elem; i++) {
+    double residual = true_value[i] - prediction[i];
+    risk += residual * residual;
+  }
+  return risk / (2 * true_value.n_elem);
+}
+
+std::string LossQuadratic::getLossType () const
+{
+  return "quadratic";
+}
+
 
 // Absolute loss:
 // -----------------------
@@ -215,6 +303,28 @@ arma::vec LossAbsolute::responseTransformation (const arma::vec& score) const
   return score;
 }
 
+/**
+ * \brief Fused computation of the empirical risk
+ * 
+ * \param true_value `arma::vec` True value of the response
+ * \param prediction `arma::vec` Prediction of the true value
+ * 
+ * \returns `double` mean of the elementwise losses
+ */
+double LossAbsolute::calculateEmpiricalRisk (const arma::vec& true_value, const arma::vec& prediction) const
+{
+  double risk = 0;
+  for (unsigned int i = 0; i < true_value.n_elem; i++) {
+    risk += std::abs(true_value[i] - prediction[i]);
+  }
+  return risk / true_value.n_elem;
+}
+
+std::string LossAbsolute::getLossType () const
+{
+  return "absolute";
+}
+
 
 // Binomial loss:
 // -----------------------
@@ -276,6 +386,31 @@ arma::vec LossBinomial::definedGradient (const arma::vec& true_value, const arma
   return - true_value / (1 + arma::exp(true_value % prediction));
 }
 
+/**
+* \brief Definition of the second derivative of the loss function (see 
+*   description of the class)
+* 
+* The second derivative is symmetric in \f$yf\f$, hence it is computed with
+* \f$\exp(-|yf|)\f$ to not overflow for large scores.
+* 
+* \param true_value `arma::vec` True value of the response
+* \param prediction `arma::vec` Prediction of the true value
+* 
+* \returns `arma::vec` vector of elementwise application of the second 
+*   derivative
+*/
+
+arma::vec LossBinomial::definedHessian (const arma::vec& true_value, const arma::vec& prediction) const
+{
+  arma::vec exp_score = arma::exp(- arma::abs(true_value % prediction));
+  return exp_score / arma::square(1 + exp_score);
+}
+
+bool LossBinomial::hasHessian () const
+{
+  return true;
+}
+
 /**
 * \brief Definition of the constant risk initialization (see description of the class)
 * 
@@ -320,6 +455,28 @@ arma::vec LossBinomial::responseTransformation (const arma::vec& score) const
   return 1 / (1 + arma::exp(-score));
 }
 
+/**
+ * \brief Fused computation of the empirical risk
+ * 
+ * \param true_value `arma::vec` True value of the response
+ * \param prediction `arma::vec` Prediction of the true value
+ * 
+ * \returns `double` mean of the elementwise losses
+ */
+double LossBinomial::calculateEmpiricalRisk (const arma::vec& true_value, const arma::vec& prediction) const
+{
+  double risk = 0;
+  for (unsigned int i = 0; i < true_value.n_elem; i++) {
+    risk += std::log(1 + std::exp(- true_value[i] * prediction[i]));
+  }
+  return risk / true_value.n_elem;
+}
+
+std::string LossBinomial::getLossType () const
+{
+  return "binomial";
+}
+
 // Custom loss:
 // -----------------------
 
@@ -409,6 +566,11 @@ arma::vec LossCustom::responseTransformation (const arma::vec& score) const
   return score;
 }
 
+bool LossCustom::usesRFunctions () const
+{
+  return true;
+}
+
 
 // Custom cpp loss:
 // -----------------------
@@ -88,12 +88,27 @@ public:
   /// Gradient of loss functions for pseudo residuals
   virtual arma::vec definedGradient (const arma::vec&, const arma::vec&) const = 0;
   
+  /// Second derivative of the loss function for Newton steps
+  virtual arma::vec definedHessian (const arma::vec&, const arma::vec&) const;
+  
+  /// Tag if the loss provides the second derivative
+  virtual bool hasHessian () const;
+  
   /// Constant initialization of the empirical risk
   virtual double constantInitializer (const arma::vec&) const = 0;
 
   /// Response function to map score to output space:
   virtual arma::vec responseTransformation (const arma::vec&) const = 0;
   
+  /// Empirical risk, the default averages the vector returned by `definedLoss`
+  virtual double calculateEmpiricalRisk (const arma::vec&, const arma::vec&) const;
+  
+  /// Tag if the loss calls `R` functions (those can't be used outside the main thread)
+  virtual bool usesRFunctions () const;
+  
+  /// Type of the loss which is stored within saved models
+  virtual std::string getLossType () const;
+  
   virtual ~Loss ();
   
 protected:
@@ -130,6 +145,10 @@ protected:
  * \f[
  *   \frac{\delta}{\delta f(x)}\ L(y, f(x)) = f(x) - y
  * \f]
+ * **Hessian:**
+ * \f[
+ *   \frac{\delta^2}{\delta f(x)^2}\ L(y, f(x)) = 1
+ * \f]
  * **Initialization:**
  * \f[
  *   \hat{f}^{[0]}(x) = \underset{c\in\mathbb{R}}{\mathrm{arg~min}}\ \frac{1}{n}\sum\limits_{i=1}^n
@@ -153,11 +172,21 @@ public:
   /// Gradient of loss functions for pseudo residuals
   arma::vec definedGradient (const arma::vec&, const arma::vec&) const;
   
+  /// Second derivative of the loss function for Newton steps
+  arma::vec definedHessian (const arma::vec&, const arma::vec&) const;
+  bool hasHessian () const;
+  
   /// Constant initialization of the empirical risk
   double constantInitializer (const arma::vec&) const;
 
   /// Definition of the response function
   arma::vec responseTransformation (const arma::vec&) const;
+  
+  /// Fused computation of the empirical risk without temporary vectors
+  double calculateEmpiricalRisk (const arma::vec&, const arma::vec&) const;
+  
+  /// Type of the loss which is stored within saved models
+  std::string getLossType () const;
 };
 
 // LossAbsolute loss:
@@ -204,6 +233,12 @@ public:
 
   /// Definition of the response function
   arma::vec responseTransformation (const arma::vec&) const;
+  
+  /// Fused computation of the empirical risk without temporary vectors
+  double calculateEmpiricalRisk (const arma::vec&, const arma::vec&) const;
+  
+  /// Type of the loss which is stored within saved models
+  std::string getLossType () const;
 };
 
 // Binomial loss:
@@ -228,6 +263,10 @@ public:
  * \f[
  *   \frac{\delta}{\delta f(x)}\ L(y, f(x)) = - \frac{y}{1 + \exp\left(2yf\right)}
  * \f]
+ * **Hessian:**
+ * \f[
+ *   \frac{\delta^2}{\delta f(x)^2}\ L(y, f(x)) = \frac{\exp\left(yf\right)}{\left(1 + \exp\left(yf\right)\right)^2}
+ * \f]
  * **Initialization:**
  * \f[
  *   \hat{f}^{[0]}(x) = \frac{1}{2}\log\left(\frac{p}{1 - p}\right)
@@ -255,11 +294,21 @@ public:
   /// Gradient of loss functions for pseudo residuals
   arma::vec definedGradient (const arma::vec&, const arma::vec&) const;
   
+  /// Second derivative of the loss function for Newton steps
+  arma::vec definedHessian (const arma::vec&, const arma::vec&) const;
+  bool hasHessian () const;
+  
   /// Constant initialization of the empirical risk
   double constantInitializer (const arma::vec&) const;
 
   /// Definition of the response function
   arma::vec responseTransformation (const arma::vec&) const;
+  
+  /// Fused computation of the empirical risk without temporary vectors
+  double calculateEmpiricalRisk (const arma::vec&, const arma::vec&) const;
+  
+  /// Type of the loss which is stored within saved models
+  std::string getLossType () const;
 };
 
 // Custom loss:
@@ -314,6 +363,9 @@ public:
 
   /// Definition of the response function
   arma::vec responseTransformation (const arma::vec&) const;
+  
+  /// The custom loss calls `R` functions
+  bool usesRFunctions () const;
 };
 
 // Custom loss:
@@ -37,26 +37,60 @@
 
 namespace optimizer {
 
+// The optimizer type is written in front of the state to not restore the
+// state of another optimizer:
+static void writeOptimizerType (std::ostream& out, const std::string& optimizer_type)
+{
+  serialize::writeString(out, optimizer_type);
+}
+
+static void readOptimizerType (std::istream& in, const std::string& optimizer_type)
+{
+  if (in.peek() == std::char_traits<char>::eof()) {
+    Rcpp::stop("The checkpoint doesn't contain the state of a '" + optimizer_type + "' optimizer.");
+  }
+  std::string saved_type = serialize::readString(in);
+  if (saved_type != optimizer_type) {
+    Rcpp::stop("The optimizer state was written by a '" + saved_type + "' optimizer and can't be restored into a '" + optimizer_type + "' optimizer.");
+  }
+}
+
 // -------------------------------------------------------------------------- //
 // Abstract 'Optimizer' class:
 // -------------------------------------------------------------------------- //
 
-// Destructor:
-Optimizer::~Optimizer () {
-  // Rcpp::Rcout << "Call Optimizer Destructor" << std::endl;
+// Fixed step of one:
+double Optimizer::calculateStepSize (loss::Loss* used_loss, const arma::vec& response, const arma::vec& prediction, 
+  blearner::Baselearner* selected_blearner, const arma::vec& blearner_prediction)
+{
+  return 1;
 }
 
-// -------------------------------------------------------------------------- //
-// Optimizer implementations:
-// -------------------------------------------------------------------------- //
+// Nothing to update by default:
+void Optimizer::updateStatistics (loss::Loss* used_loss, blearner::Baselearner* selected_blearner, 
+  const double& learning_rate, const double& momentum) {}
 
-// OptimizerCoordinateDescent:
-// -----------------------
+void Optimizer::setPredictionVersion (const unsigned int& version, const unsigned int& iteration) {}
 
-OptimizerCoordinateDescent::OptimizerCoordinateDescent () {}
+// No state by default:
+void Optimizer::saveOptimizerState (std::ostream& out) const {}
 
-blearner::Baselearner* OptimizerCoordinateDescent::findBestBaselearner (const std::string& iteration_id, 
-  const arma::vec& pseudo_residuals, const blearner_factory_map& my_blearner_factory_map) const
+void Optimizer::loadOptimizerState (std::istream& in) {}
+
+// Destructor:
+Optimizer::~Optimizer () {
+  // Rcpp::Rcout << "Call Optimizer Destructor" << std::endl;
+}
+
+// Train the base-learner of every given factory and select the one with the
+// smallest SSE. If row indices are given, the pseudo residuals belong to this
+// subsample of the rows and every factory must be able to train on it. If
+// weights are given (Newton steps), the pseudo residuals are the negative 
+// gradient and the weights the hessian. The base-learners are then fitted to
+// the negative gradient divided by the hessian by weighted least squares:
+blearner::Baselearner* Optimizer::selectBaselearner (const std::string& iteration_id, 
+  const arma::vec& pseudo_residuals, const arma::vec& weights, const arma::uvec& row_idx, 
+  const blearner_factory_map& my_blearner_factory_map, std::map<std::string, double>* ssq_map) const
 {
   double ssq_temp;
   double ssq_best = std::numeric_limits<double>::infinity();
@@ -64,6 +98,57 @@ blearner::Baselearner* OptimizerCoordinateDescent::findBestBaselearner (const st
   blearner::Baselearner* blearner_temp;
   blearner::Baselearner* blearner_best;
   
+  bool use_subsample = row_idx.n_elem > 0;
+  bool use_weights   = weights.n_elem > 0;
+  bool use_gram      = use_subsample || use_weights;
+  
+  // Compute X^T r of all linear base-learners in one sweep over the rows. The
+  // block of the pseudo residuals stays in the cache while every factory 
+  // multiplies its rows of the design matrix. On a subsample or with weights,
+  // X^T W X is accumulated in the same sweep:
+  std::map<std::string, arma::vec> crossprods;
+  std::map<std::string, arma::mat> grams;
+  struct SweepFactory
+  {
+    blearnerfactory::BaselearnerFactory* factory;
+    arma::vec* crossprod;
+    arma::mat* gram;
+  };
+  std::vector<SweepFactory> sweep_factories;
+  for (auto& it : my_blearner_factory_map) {
+    unsigned int crossprod_size;
+    if (use_gram) {
+      crossprod_size = it.second->getSubsampleSize();
+      if (crossprod_size == 0 && use_weights) {
+        throw std::runtime_error("Base-learner " + it.first + " can't be trained with weights (Newton steps).");
+      }
+      if (crossprod_size == 0) {
+        throw std::runtime_error("Base-learner " + it.first + " can't be trained on a subsample of the rows.");
+      }
+      grams[it.first] = arma::mat(crossprod_size, crossprod_size, arma::fill::zeros);
+    } else {
+      crossprod_size = it.second->getCrossprodSize();
+    }
+    if (crossprod_size > 0) {
+      crossprods[it.first] = arma::vec(crossprod_size, arma::fill::zeros);
+      sweep_factories.push_back({ it.second, &crossprods[it.first], use_gram ? &grams[it.first] : NULL });
+    }
+  }
+  unsigned int block_size = 4096;
+  for (unsigned int first = 0; first < pseudo_residuals.n_elem; first += block_size) {
+    unsigned int last = std::min<unsigned int>(first + block_size, pseudo_residuals.n_elem) - 1;
+    for (auto& it : sweep_factories) {
+      if (use_gram) {
+        it.factory->addSubsampleBlock(pseudo_residuals, row_idx, weights, first, last, *it.crossprod, *it.gram);
+      } else {
+        it.factory->addCrossprodBlock(pseudo_residuals, first, last, *it.crossprod);
+      }
+    }
+  }
+  blearner::ResponseSummary response_summary = use_weights 
+    ? blearner::ResponseSummary(pseudo_residuals, weights) 
+    : blearner::ResponseSummary(pseudo_residuals);
+  
   for (auto& it : my_blearner_factory_map) {
 
     // Paste string identifier for new base-learner:
@@ -73,11 +158,20 @@ blearner::Baselearner* OptimizerCoordinateDescent::findBestBaselearner (const st
     // pointer is overwritten):
     blearner_temp = it.second->createBaselearner(id);
     
-    // Train that base learner on the pseudo residuals:
-    blearner_temp->train(pseudo_residuals);
-    
-    // Calculate SSE:
-    ssq_temp = arma::mean(arma::pow(pseudo_residuals - blearner_temp->predict(), 2));
+    // Train that base learner on the pseudo residuals and calculate SSE. If
+    // the cross product is available, the SSE is computed without predicting:
+    std::map<std::string, arma::vec>::iterator it_crossprod = crossprods.find(it.first);
+    if (use_gram) {
+      ssq_temp = blearner_temp->trainSubsample(it_crossprod->second, grams[it.first], response_summary) / response_summary.n_obs;
+    } else if (it_crossprod != crossprods.end()) {
+      ssq_temp = blearner_temp->trainCrossprod(it_crossprod->second, response_summary) / response_summary.n_obs;
+    } else {
+      blearner_temp->train(pseudo_residuals);
+      ssq_temp = arma::mean(arma::pow(pseudo_residuals - blearner_temp->predict(), 2));
+    }
+    if (ssq_map != NULL) {
+      (*ssq_map)[it.first] = ssq_temp;
+    }
     
     // Check if SSE of new temporary baselearner is smaller then SSE of the best
     // baselearner. If so, assign the temporary base-learner with the best 
@@ -100,4 +194,660 @@ blearner::Baselearner* OptimizerCoordinateDescent::findBestBaselearner (const st
   return blearner_best;
 }
 
+// -------------------------------------------------------------------------- //
+// Optimizer implementations:
+// -------------------------------------------------------------------------- //
+
+// OptimizerCoordinateDescent:
+// -----------------------
+
+OptimizerCoordinateDescent::OptimizerCoordinateDescent () {}
+
+blearner::Baselearner* OptimizerCoordinateDescent::findBestBaselearner (const std::string& iteration_id, 
+  const arma::vec& pseudo_residuals, const arma::vec& weights, const arma::uvec& row_idx, 
+  const blearner_factory_map& my_blearner_factory_map)
+{
+  return selectBaselearner(iteration_id, pseudo_residuals, weights, row_idx, my_blearner_factory_map);
+}
+
+// OptimizerCoordinateDescentLineSearch:
+// -----------------------
+
+OptimizerCoordinateDescentLineSearch::OptimizerCoordinateDescentLineSearch () {}
+
+/**
+ * \brief Minimize the risk along the base-learner by Newton's method
+ * 
+ * The first and second derivative of the risk with respect to the step 
+ * \f$s\f$ are \f$\sum_i g_i b_i\f$ and \f$\sum_i h_i b_i^2\f$ with the 
+ * gradient \f$g\f$ and hessian \f$h\f$ of the loss at the prediction plus
+ * \f$s b\f$. One step is exact for the quadratic loss. The step is rejected 
+ * if the iteration doesn't converge or the risk doesn't decrease.
+ * 
+ * \param used_loss `loss::Loss*` loss with second derivative
+ * \param response `arma::vec` response
+ * \param prediction `arma::vec` prediction before the update
+ * \param blearner_prediction `arma::vec` prediction of the base-learner
+ * \param step_size `double` the found step size
+ * 
+ * \returns `bool` if a step is found
+ */
+bool OptimizerCoordinateDescentLineSearch::findNewtonStep (loss::Loss* used_loss, const arma::vec& response, 
+  const arma::vec& prediction, const arma::vec& blearner_prediction, double& step_size)
+{
+  const arma::vec blearner_prediction_sq = arma::square(blearner_prediction);
+  double step = 0;
+  bool converged = false;
+  
+  step_prediction = prediction;
+  for (unsigned int i = 0; i < 20; i++) {
+    double first  = arma::dot(used_loss->definedGradient(response, step_prediction), blearner_prediction);
+    double second = arma::dot(used_loss->definedHessian(response, step_prediction), blearner_prediction_sq);
+    if (! (second > 0) || ! std::isfinite(first)) {
+      return false;
+    }
+    double delta = first / second;
+    step -= delta;
+    step_prediction = prediction + step * blearner_prediction;
+    if (std::abs(delta) <= 1e-10 * std::max(1.0, std::abs(step))) {
+      converged = true;
+      break;
+    }
+  }
+  if (! converged || ! std::isfinite(step)) {
+    return false;
+  }
+  if (used_loss->calculateEmpiricalRisk(response, step_prediction) > used_loss->calculateEmpiricalRisk(response, prediction)) {
+    return false;
+  }
+  step_size = step;
+  return true;
+}
+
+double OptimizerCoordinateDescentLineSearch::calculateStepSize (loss::Loss* used_loss, const arma::vec& response, 
+  const arma::vec& prediction, blearner::Baselearner* selected_blearner, const arma::vec& blearner_prediction)
+{
+  // The step is folded into the parameter, which requires a prediction that
+  // is linear in the parameter:
+  if (! selected_blearner->isLinearInParameter()) {
+    step_sizes.push_back(1);
+    return 1;
+  }
+  double step_size = 1;
+  if (used_loss->hasHessian() && findNewtonStep(used_loss, response, prediction, blearner_prediction, step_size)) {
+    step_sizes.push_back(step_size);
+    return step_size;
+  }
+  
+  // The candidate prediction is written into the same vector for every step:
+  step_prediction.set_size(prediction.n_elem);
+  auto stepRisk = [&] (const double& step) {
+    step_prediction = prediction + step * blearner_prediction;
+    return used_loss->calculateEmpiricalRisk(response, step_prediction);
+  };
+  
+  // Bracket the minimum by doubling the step as long as the risk decreases.
+  // The step of one is the least squares fit of the pseudo residuals:
+  double step_lower = 0;
+  double step_upper = 1;
+  double risk_upper = stepRisk(step_upper);
+  while (step_upper < 1024) {
+    double risk_temp = stepRisk(2 * step_upper);
+    if (risk_temp >= risk_upper) {
+      break;
+    }
+    step_lower = step_upper / 2;
+    step_upper *= 2;
+    risk_upper = risk_temp;
+  }
+  step_upper *= 2;
+  
+  // Golden section search within the bracket:
+  const double golden_ratio = (std::sqrt(5.0) - 1) / 2;
+  double step_left  = step_upper - golden_ratio * (step_upper - step_lower);
+  double step_right = step_lower + golden_ratio * (step_upper - step_lower);
+  double risk_left  = stepRisk(step_left);
+  double risk_right = stepRisk(step_right);
+  for (unsigned int i = 0; i < 40; i++) {
+    if (risk_left < risk_right) {
+      step_upper = step_right;
+      step_right = step_left;
+      risk_right = risk_left;
+      step_left  = step_upper - golden_ratio * (step_upper - step_lower);
+      risk_left  = stepRisk(step_left);
+    } else {
+      step_lower = step_left;
+      step_left  = step_right;
+      risk_left  = risk_right;
+      step_right = step_lower + golden_ratio * (step_upper - step_lower);
+      risk_right = stepRisk(step_right);
+    }
+  }
+  step_size = (step_lower + step_upper) / 2;
+  step_sizes.push_back(step_size);
+  
+  return step_size;
+}
+
+std::vector<double> OptimizerCoordinateDescentLineSearch::getStepSizes () const
+{
+  return step_sizes;
+}
+
+// OptimizerRandomCoordinateDescent:
+// -----------------------
+
+OptimizerRandomCoordinateDescent::OptimizerRandomCoordinateDescent (const double& fraction, 
+  const unsigned int& window, const unsigned int& seed)
+  : fraction ( fraction ),
+    window ( window ),
+    random_generator ( seed )
+{
+  if (fraction <= 0 || fraction > 1) {
+    Rcpp::stop("The fraction of evaluated factories must be in (0, 1].");
+  }
+}
+
+blearner::Baselearner* OptimizerRandomCoordinateDescent::findBestBaselearner (const std::string& iteration_id, 
+  const arma::vec& pseudo_residuals, const arma::vec& weights, const arma::uvec& row_idx, 
+  const blearner_factory_map& my_blearner_factory_map)
+{
+  iteration++;
+  
+  // Factories which exceed the window are evaluated in any case, the others
+  // are candidates for the random subset:
+  blearner_factory_map evaluated_factories;
+  std::vector<std::string> candidates;
+  for (auto& it : my_blearner_factory_map) {
+    std::map<std::string, unsigned int>::iterator it_last = last_evaluation.find(it.first);
+    unsigned int last = (it_last == last_evaluation.end()) ? 0 : it_last->second;
+    
+    if (window > 0 && iteration - last >= window) {
+      evaluated_factories.insert(it);
+    } else {
+      candidates.push_back(it.first);
+    }
+  }
+  unsigned int n_evaluate = std::ceil(fraction * my_blearner_factory_map.size());
+  
+  if (evaluated_factories.size() < n_evaluate) {
+    // Partial Fisher-Yates shuffle. `std::shuffle` is implementation defined,
+    // the modulo of the generator draws the same subset with every standard
+    // library (e.g. for a checkpoint which is resumed on another platform):
+    unsigned int n_draw = n_evaluate - evaluated_factories.size();
+    for (unsigned int i = 0; i < n_draw; i++) {
+      unsigned int j = i + random_generator() % (candidates.size() - i);
+      std::swap(candidates[i], candidates[j]);
+    }
+    candidates.resize(n_draw);
+    
+    for (auto& id : candidates) {
+      evaluated_factories.insert(*my_blearner_factory_map.find(id));
+    }
+  }
+  for (auto& it : evaluated_factories) {
+    last_evaluation[it.first] = iteration;
+  }
+  return selectBaselearner(iteration_id, pseudo_residuals, weights, row_idx, evaluated_factories);
+}
+
+// The generator is written in its textual representation which is the 
+// portable way to store the state of the standard engines:
+void OptimizerRandomCoordinateDescent::saveOptimizerState (std::ostream& out) const
+{
+  writeOptimizerType(out, "random");
+  serialize::writeUInt(out, iteration);
+  serialize::writeUInt(out, last_evaluation.size());
+  for (auto& it : last_evaluation) {
+    serialize::writeString(out, it.first);
+    serialize::writeUInt(out, it.second);
+  }
+  std::ostringstream generator_state;
+  generator_state << random_generator;
+  serialize::writeString(out, generator_state.str());
+}
+
+void OptimizerRandomCoordinateDescent::loadOptimizerState (std::istream& in)
+{
+  readOptimizerType(in, "random");
+  iteration = serialize::readUInt(in);
+  
+  last_evaluation.clear();
+  unsigned int n_factories = serialize::readUInt(in);
+  for (unsigned int i = 0; i < n_factories; i++) {
+    std::string factory_id = serialize::readString(in);
+    last_evaluation[factory_id] = serialize::readUInt(in);
+  }
+  std::istringstream generator_state (serialize::readString(in));
+  generator_state >> random_generator;
+  if (generator_state.fail()) {
+    Rcpp::stop("The state of the random number generator is corrupted.");
+  }
+}
+
+// OptimizerLazyCoordinateDescent:
+// -----------------------
+
+OptimizerLazyCoordinateDescent::OptimizerLazyCoordinateDescent () {}
+
+/**
+ * \brief Find the best base-learner without evaluating all factories
+ * 
+ * For a linear smoother, the reduction of the SSE is \f$g(r) = \|A r\|^2\f$
+ * with \f$\|A\| \leq 1\f$. Hence, \f$\sqrt{g(r_t)} \leq \sqrt{g(r_s)} + 
+ * \|r_t - r_s\|\f$ where \f$s\f$ is the iteration of the last evaluation. 
+ * The distance is bounded by the cumulated changes of the pseudo residuals.
+ * First, the factory with the largest bound (and all factories without a 
+ * bound) are evaluated. Then, all factories whose bound is at least the best
+ * reduction are evaluated in one sweep. The remaining factories can't be
+ * better, hence the selected base-learner equals the one of the coordinate
+ * descent. On a subsample of the rows or with Newton steps, all factories
+ * are evaluated.
+ */
+blearner::Baselearner* OptimizerLazyCoordinateDescent::findBestBaselearner (const std::string& iteration_id, 
+  const arma::vec& pseudo_residuals, const arma::vec& weights, const arma::uvec& row_idx, 
+  const blearner_factory_map& my_blearner_factory_map)
+{
+  // The bounds are just valid for the unweighted pseudo residuals of the 
+  // same rows:
+  bool use_bounds = row_idx.n_elem == 0 && weights.n_elem == 0;
+  if (! use_bounds || last_pseudo_residuals.n_elem != pseudo_residuals.n_elem) {
+    last_reduction.clear();
+    last_residual_path.clear();
+  } else {
+    residual_path += arma::norm(pseudo_residuals - last_pseudo_residuals);
+  }
+  if (use_bounds) {
+    last_pseudo_residuals = pseudo_residuals;
+  }
+  double response_ssq = arma::dot(pseudo_residuals, pseudo_residuals);
+  
+  std::map<std::string, double> bounds;
+  blearner_factory_map first_factories;
+  for (auto& it : my_blearner_factory_map) {
+    std::map<std::string, double>::iterator it_reduction = last_reduction.find(it.first);
+    if (it.second->isLinearSmoother() && it_reduction != last_reduction.end()) {
+      double bound = std::sqrt(it_reduction->second) + residual_path - last_residual_path[it.first];
+      bounds[it.first] = bound * bound;
+    } else {
+      first_factories.insert(it);
+    }
+  }
+  std::map<std::string, double>::iterator it_max_bound = bounds.begin();
+  for (std::map<std::string, double>::iterator it = bounds.begin(); it != bounds.end(); it++) {
+    if (it->second > it_max_bound->second) { it_max_bound = it; }
+  }
+  if (it_max_bound != bounds.end()) {
+    first_factories.insert(*my_blearner_factory_map.find(it_max_bound->first));
+    bounds.erase(it_max_bound);
+  }
+  std::map<std::string, double> ssq_map;
+  blearner::Baselearner* blearner_best = selectBaselearner(iteration_id, pseudo_residuals, weights, row_idx, 
+    first_factories, &ssq_map);
+  
+  double n_obs = pseudo_residuals.n_elem;
+  double ssq_best = std::numeric_limits<double>::infinity();
+  for (auto& it : ssq_map) {
+    ssq_best = std::min(ssq_best, it.second);
+  }
+  
+  // Factories which could beat the best one (with some slack for rounding 
+  // errors of the reductions):
+  blearner_factory_map second_factories;
+  for (auto& it : bounds) {
+    if (it.second * (1 + 1e-10) >= response_ssq - n_obs * ssq_best) {
+      second_factories.insert(*my_blearner_factory_map.find(it.first));
+    }
+  }
+  if (second_factories.size() > 0) {
+    std::map<std::string, double> ssq_map_second;
+    blearner::Baselearner* blearner_second = selectBaselearner(iteration_id, pseudo_residuals, weights, row_idx, 
+      second_factories, &ssq_map_second);
+    
+    double ssq_second = std::numeric_limits<double>::infinity();
+    for (auto& it : ssq_map_second) {
+      ssq_second = std::min(ssq_second, it.second);
+      ssq_map[it.first] = it.second;
+    }
+    if (ssq_second < ssq_best) {
+      delete blearner_best;
+      blearner_best = blearner_second;
+    } else {
+      delete blearner_second;
+    }
+  }
+  // Store the reductions of the evaluated factories:
+  if (use_bounds) {
+    for (auto& it : ssq_map) {
+      last_reduction[it.first]     = std::max(0.0, response_ssq - n_obs * it.second);
+      last_residual_path[it.first] = residual_path;
+    }
+  }
+  n_evaluated.push_back(ssq_map.size());
+  n_pruned.push_back(my_blearner_factory_map.size() - ssq_map.size());
+  
+  return blearner_best;
+}
+
+std::vector<unsigned int> OptimizerLazyCoordinateDescent::getNumberOfEvaluatedFactories () const
+{
+  return n_evaluated;
+}
+
+std::vector<unsigned int> OptimizerLazyCoordinateDescent::getNumberOfPrunedFactories () const
+{
+  return n_pruned;
+}
+
+// OptimizerWorkingSetCoordinateDescent:
+// -----------------------
+
+OptimizerWorkingSetCoordinateDescent::OptimizerWorkingSetCoordinateDescent (const unsigned int& n_working_set, 
+  const unsigned int& refresh_iterations)
+  : n_working_set ( n_working_set ),
+    refresh_iterations ( refresh_iterations )
+{
+  if (n_working_set == 0) {
+    Rcpp::stop("The working set must contain at least one base-learner.");
+  }
+  if (refresh_iterations == 0) {
+    Rcpp::stop("The number of iterations between two full sweeps must be at least one.");
+  }
+}
+
+blearner::Baselearner* OptimizerWorkingSetCoordinateDescent::findBestBaselearner (const std::string& iteration_id, 
+  const arma::vec& pseudo_residuals, const arma::vec& weights, const arma::uvec& row_idx, 
+  const blearner_factory_map& my_blearner_factory_map)
+{
+  // Collect the working set. A full sweep is done if it is due or if a 
+  // factory of the working set isn't registered anymore:
+  blearner_factory_map working_set_factories;
+  bool full_sweep = working_set.empty() || iterations_since_refresh >= refresh_iterations;
+  for (auto& id : working_set) {
+    blearner_factory_map::const_iterator it = my_blearner_factory_map.find(id);
+    if (it == my_blearner_factory_map.end()) {
+      full_sweep = true;
+      break;
+    }
+    working_set_factories.insert(*it);
+  }
+  full_sweeps.push_back(full_sweep);
+  
+  if (! full_sweep) {
+    iterations_since_refresh++;
+    return selectBaselearner(iteration_id, pseudo_residuals, weights, row_idx, working_set_factories);
+  }
+  std::map<std::string, double> ssq_map;
+  blearner::Baselearner* blearner_best = selectBaselearner(iteration_id, pseudo_residuals, weights, row_idx, 
+    my_blearner_factory_map, &ssq_map);
+  
+  // The new working set are the factories with the smallest SSE:
+  std::vector<std::pair<double, std::string>> ranking;
+  for (auto& it : ssq_map) {
+    ranking.push_back(std::make_pair(it.second, it.first));
+  }
+  std::sort(ranking.begin(), ranking.end());
+  
+  working_set.clear();
+  for (unsigned int i = 0; i < std::min<unsigned int>(n_working_set, ranking.size()); i++) {
+    working_set.push_back(ranking[i].second);
+  }
+  iterations_since_refresh = 1;
+  
+  return blearner_best;
+}
+
+std::vector<bool> OptimizerWorkingSetCoordinateDescent::getFullSweeps () const
+{
+  return full_sweeps;
+}
+
+void OptimizerWorkingSetCoordinateDescent::saveOptimizerState (std::ostream& out) const
+{
+  writeOptimizerType(out, "working.set");
+  serialize::writeUInt(out, iterations_since_refresh);
+  serialize::writeUInt(out, working_set.size());
+  for (auto& id : working_set) {
+    serialize::writeString(out, id);
+  }
+  arma::vec sweeps (full_sweeps.size());
+  for (unsigned int i = 0; i < full_sweeps.size(); i++) {
+    sweeps(i) = full_sweeps[i];
+  }
+  serialize::writeMat(out, sweeps);
+}
+
+void OptimizerWorkingSetCoordinateDescent::loadOptimizerState (std::istream& in)
+{
+  readOptimizerType(in, "working.set");
+  iterations_since_refresh = serialize::readUInt(in);
+  
+  working_set.clear();
+  unsigned int n_saved = serialize::readUInt(in);
+  for (unsigned int i = 0; i < n_saved; i++) {
+    working_set.push_back(serialize::readString(in));
+  }
+  arma::vec sweeps = serialize::readMat(in);
+  full_sweeps.assign(sweeps.begin(), sweeps.end());
+}
+
+// OptimizerCachedCoordinateDescent:
+// -----------------------
+
+OptimizerCachedCoordinateDescent::OptimizerCachedCoordinateDescent (const unsigned int& n_cached)
+  : n_cached ( n_cached )
+{
+  if (n_cached == 0) {
+    Rcpp::stop("The cross products of at least one base-learner must be cached.");
+  }
+}
+
+// Compute X_j^T r of all factories in one sweep over the rows. The Gram 
+// matrices don't depend on the pseudo residuals and are just computed if the
+// rows or the factories changed:
+void OptimizerCachedCoordinateDescent::computeStatistics (const arma::vec& pseudo_residuals, 
+  const blearner_factory_map& my_blearner_factory_map)
+{
+  bool compute_grams = (statistics_n_obs != pseudo_residuals.n_elem) 
+    || (grams.size() != my_blearner_factory_map.size());
+  for (auto& it : my_blearner_factory_map) {
+    if (grams.find(it.first) == grams.end()) { compute_grams = true; }
+  }
+  if (compute_grams) {
+    grams.clear();
+    cross_grams.clear();
+    last_use.clear();
+  }
+  crossprods.clear();
+  for (auto& it : my_blearner_factory_map) {
+    unsigned int design_size = it.second->getSubsampleSize();
+    crossprods[it.first] = arma::vec(design_size, arma::fill::zeros);
+    if (compute_grams) {
+      grams[it.first] = arma::mat(design_size, design_size, arma::fill::zeros);
+    }
+  }
+  unsigned int block_size = 4096;
+  for (unsigned int first = 0; first < pseudo_residuals.n_elem; first += block_size) {
+    unsigned int last = std::min<unsigned int>(first + block_size, pseudo_residuals.n_elem) - 1;
+    for (auto& it : my_blearner_factory_map) {
+      blearnerfactory::DesignBlock design = it.second->getDesignBlock(first, last);
+      crossprods[it.first] += design.crossprod(pseudo_residuals.subvec(first, last));
+      if (compute_grams) {
+        grams[it.first] += design.gram();
+      }
+    }
+  }
+}
+
+// Compute X_j^T X_s of all factories j and the selected factory s in one 
+// sweep over the rows. If more than `n_cached` factories are cached, the 
+// least recently selected one is removed:
+void OptimizerCachedCoordinateDescent::computeCrossGrams (const std::string& selected_id, 
+  const blearner_factory_map& my_blearner_factory_map)
+{
+  blearnerfactory::BaselearnerFactory* selected = my_blearner_factory_map.find(selected_id)->second;
+  unsigned int n_obs = statistics_n_obs;
+  
+  std::map<std::string, arma::mat>& selected_grams = cross_grams[selected_id];
+  for (auto& it : my_blearner_factory_map) {
+    if (it.first != selected_id) {
+      selected_grams[it.first] = arma::mat(crossprods[it.first].n_elem, crossprods[selected_id].n_elem, arma::fill::zeros);
+    } else {
+      selected_grams[it.first] = grams[selected_id];
+    }
+  }
+  unsigned int block_size = 4096;
+  for (unsigned int first = 0; first < n_obs; first += block_size) {
+    unsigned int last = std::min<unsigned int>(first + block_size, n_obs) - 1;
+    blearnerfactory::DesignBlock selected_design = selected->getDesignBlock(first, last);
+    for (auto& it : my_blearner_factory_map) {
+      if (it.first != selected_id) {
+        selected_grams[it.first] += it.second->getDesignBlock(first, last).crossGram(selected_design);
+      }
+    }
+  }
+  last_use[selected_id] = iteration;
+  
+  while (cross_grams.size() > n_cached) {
+    std::string oldest_id;
+    unsigned int oldest_use = iteration;
+    for (auto& it : last_use) {
+      if (it.first != selected_id && it.second <= oldest_use) {
+        oldest_id  = it.first;
+        oldest_use = it.second;
+      }
+    }
+    cross_grams.erase(oldest_id);
+    last_use.erase(oldest_id);
+  }
+}
+
+/**
+ * \brief Find the best base-learner from cached cross products
+ * 
+ * Every factory is trained from \f$X_j^T r\f$ and \f$X_j^T X_j\f$ (see 
+ * `trainSubsample()`), which doesn't require a sweep over the rows. After 
+ * the selected factory \f$s\f$ updated the prediction by 
+ * \f$\nu X_s \beta_s\f$, the pseudo residuals of the quadratic loss change
+ * by \f$-\nu X_s \beta_s\f$, hence the cross products are updated by 
+ * \f[
+ *   X_j^T r \leftarrow X_j^T r - \nu X_j^T X_s \beta_s.
+ * \f]
+ * The cross products belong to the version and iteration of the prediction
+ * (see `setPredictionVersion()`), otherwise they are computed from scratch.
+ * On a subsample of the rows, with Newton steps, or with factories which 
+ * don't provide their design matrix, all base-learners are trained as by the
+ * greedy optimizer.
+ */
+blearner::Baselearner* OptimizerCachedCoordinateDescent::findBestBaselearner (const std::string& iteration_id, 
+  const arma::vec& pseudo_residuals, const arma::vec& weights, const arma::uvec& row_idx, 
+  const blearner_factory_map& my_blearner_factory_map)
+{
+  iteration++;
+  
+  bool use_statistics = loss_is_quadratic && row_idx.n_elem == 0 && weights.n_elem == 0;
+  for (auto& it : my_blearner_factory_map) {
+    if (it.second->getSubsampleSize() == 0) { use_statistics = false; }
+  }
+  if (! use_statistics) {
+    statistics_are_valid = false;
+    selected_factory.clear();
+    full_sweeps.push_back(true);
+    return selectBaselearner(iteration_id, pseudo_residuals, weights, row_idx, my_blearner_factory_map);
+  }
+  blearner::ResponseSummary response_summary (pseudo_residuals);
+  
+  // The cached statistics must belong to the registered factories:
+  bool same_factories = crossprods.size() == my_blearner_factory_map.size();
+  for (auto& it : my_blearner_factory_map) {
+    if (crossprods.find(it.first) == crossprods.end()) { same_factories = false; }
+  }
+  statistics_are_valid = statistics_are_valid && same_factories 
+    && statistics_n_obs == response_summary.n_obs;
+  
+  // Update the statistics by the base-learner selected in the last iteration:
+  if (statistics_are_valid && selected_update.n_elem > 0) {
+    if (cross_grams.find(selected_factory) == cross_grams.end()) {
+      computeCrossGrams(selected_factory, my_blearner_factory_map);
+    }
+    last_use[selected_factory] = iteration;
+    
+    const std::map<std::string, arma::mat>& selected_grams = cross_grams[selected_factory];
+    for (auto& it : crossprods) {
+      it.second -= selected_grams.find(it.first)->second * selected_update;
+    }
+  }
+  selected_update.reset();
+  
+  bool full_sweep = ! statistics_are_valid;
+  if (full_sweep) {
+    computeStatistics(pseudo_residuals, my_blearner_factory_map);
+    statistics_n_obs = response_summary.n_obs;
+    statistics_are_valid = true;
+  }
+  full_sweeps.push_back(full_sweep);
+  
+  double ssq_best = std::numeric_limits<double>::infinity();
+  blearner::Baselearner* blearner_best = NULL;
+  for (auto& it : my_blearner_factory_map) {
+    std::string id = "(" + iteration_id + ") " + it.second->getBaselearnerType();
+    blearner::Baselearner* blearner_temp = it.second->createBaselearner(id);
+    
+    double ssq_temp = blearner_temp->trainSubsample(crossprods[it.first], grams[it.first], response_summary);
+    if (ssq_temp < ssq_best) {
+      ssq_best = ssq_temp;
+      if (blearner_best != NULL) { delete blearner_best; }
+      blearner_best    = blearner_temp;
+      selected_factory = it.first;
+    } else {
+      delete blearner_temp;
+    }
+  }
+  return blearner_best;
+}
+
+// The pseudo residuals of the quadratic loss are y - f, hence they change by
+// the shrunken prediction of the selected base-learner. Other losses use the
+// greedy optimizer:
+void OptimizerCachedCoordinateDescent::updateStatistics (loss::Loss* used_loss, 
+  blearner::Baselearner* selected_blearner, const double& learning_rate, const double& momentum)
+{
+  statistics_iteration += 1;
+  selected_update.reset();
+  if (dynamic_cast<loss::LossQuadratic*>(used_loss) == NULL) {
+    loss_is_quadratic = false;
+  }
+  if (! loss_is_quadratic || momentum != 0 || selected_factory.empty()) {
+    statistics_are_valid = false;
+    return;
+  }
+  selected_update = learning_rate * arma::vectorise(selected_blearner->getParameter());
+}
+
+// The statistics follow the prediction of one iteration. A model which was
+// set to another iteration in between continues from the same prediction.
+// The cross products X_j^T X_s don't depend on the pseudo residuals and are
+// kept:
+void OptimizerCachedCoordinateDescent::setPredictionVersion (const unsigned int& version, 
+  const unsigned int& iteration)
+{
+  if (version != statistics_version || iteration != statistics_iteration) {
+    statistics_are_valid = false;
+    selected_factory.clear();
+    selected_update.reset();
+  }
+  statistics_version   = version;
+  statistics_iteration = iteration;
+}
+
+std::vector<bool> OptimizerCachedCoordinateDescent::getFullSweeps () const
+{
+  return full_sweeps;
+}
+
+unsigned int OptimizerCachedCoordinateDescent::getNumberOfCachedFactories () const
+{
+  return cross_grams.size();
+}
+
 } // namespace optimizer
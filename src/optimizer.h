@@ -38,12 +38,17 @@
 
 #include <iostream>
 #include <map>
+#include <vector>
 #include <limits>
+#include <random>
+#include <algorithm>
+#include <cmath>
 
 #include <RcppArmadillo.h>
 
 #include "baselearner.h"
 #include "baselearner_factory_list.h"
+#include "loss.h"
 
 namespace optimizer {
 
@@ -55,14 +60,52 @@ class Optimizer
 {
   public:
     
+    // Optimizers may keep a state over the iterations (e.g. a random number
+    // generator), hence the selection is not const. The weights of the rows
+    // are given for Newton steps (empty otherwise). The row indices are the
+    // rows of the pseudo residuals if the rows are subsampled (empty if all
+    // rows are used):
     virtual blearner::Baselearner* findBestBaselearner (const std::string&, 
-      const arma::vec&, const blearner_factory_map&) const = 0;
+      const arma::vec&, const arma::vec&, const arma::uvec&, const blearner_factory_map&) = 0;
+    
+    // Step size of the selected base-learner which is multiplied with the
+    // learning rate. The arguments are the loss, response, actual prediction,
+    // and the selected base-learner with its prediction. The default is a
+    // fixed step of one:
+    virtual double calculateStepSize (loss::Loss*, const arma::vec&, const arma::vec&, 
+      blearner::Baselearner*, const arma::vec&);
+    
+    // Called after the prediction is updated by the selected base-learner. 
+    // The arguments are the loss, the selected base-learner (with the step
+    // size folded into the parameter), the learning rate, and the momentum.
+    // Optimizers which keep statistics of the pseudo residuals follow the 
+    // update here. The default does nothing:
+    virtual void updateStatistics (loss::Loss*, blearner::Baselearner*, const double&, const double&);
+    
+    // Called before the training starts with the version of the prediction
+    // and the iteration it belongs to. The version changes if the prediction
+    // is computed anew (a new training, a restored checkpoint, or row 
+    // subsampling). Statistics of the pseudo residuals are just valid for the
+    // version and iteration they follow. The default does nothing:
+    virtual void setPredictionVersion (const unsigned int&, const unsigned int&);
+    
+    // State of the selection which is written into a checkpoint to continue
+    // the training exactly as an uninterrupted one. The default writes 
+    // nothing since most optimizers just depend on the pseudo residuals:
+    virtual void saveOptimizerState (std::ostream&) const;
+    virtual void loadOptimizerState (std::istream&);
     
     virtual ~Optimizer ();
 
   protected:
     
     blearner_factory_map my_blearner_factory_map;
+    
+    // Train the base-learners of all given factories and return the one with
+    // the smallest SSE. The SSE (mean of the squared errors) of every factory
+    // is written into the map if one is given:
+    blearner::Baselearner* selectBaselearner (const std::string&, const arma::vec&, const arma::vec&, 
+      const arma::uvec&, const blearner_factory_map&, std::map<std::string, double>* = NULL) const;
 
 };
 
@@ -81,9 +124,201 @@ class OptimizerCoordinateDescent : public Optimizer
     OptimizerCoordinateDescent ();
 
     blearner::Baselearner* findBestBaselearner (const std::string&, 
-      const arma::vec&, const blearner_factory_map&) const;
+      const arma::vec&, const arma::vec&, const arma::uvec&, const blearner_factory_map&);
+};
+
+// Greedy with line search:
+// -----------------------
+
+// Same selection as the greedy optimizer, but the step is the minimizer of
+// the empirical risk along the prediction of the selected base-learner. The
+// minimum is searched by Newton's method if the loss has a second derivative
+// and by golden section otherwise or if Newton's method fails:
+
+class OptimizerCoordinateDescentLineSearch : public OptimizerCoordinateDescent
+{
+  private:
+    
+    std::vector<double> step_sizes;
+    
+    // Candidate prediction, reused for every evaluated step:
+    arma::vec step_prediction;
+    
+    bool findNewtonStep (loss::Loss*, const arma::vec&, const arma::vec&, const arma::vec&, double&);
+    
+  public:
+    
+    OptimizerCoordinateDescentLineSearch ();
+    
+    double calculateStepSize (loss::Loss*, const arma::vec&, const arma::vec&, 
+      blearner::Baselearner*, const arma::vec&);
+    
+    std::vector<double> getStepSizes () const;
+};
+
+// Random coordinate descent:
+// -----------------------
+
+// Just a random fraction of the factories is evaluated in every iteration. 
+// Factories which were not evaluated within the last `window` iterations are
+// always evaluated (a window of zero disables this guarantee):
+
+class OptimizerRandomCoordinateDescent : public Optimizer
+{
+  private:
+    
+    const double fraction;
+    const unsigned int window;
+    
+    std::mt19937 random_generator;
+    unsigned int iteration = 0;
+    std::map<std::string, unsigned int> last_evaluation;
+    
+  public:
+    
+    OptimizerRandomCoordinateDescent (const double&, const unsigned int&, const unsigned int&);
+    
+    blearner::Baselearner* findBestBaselearner (const std::string&, 
+      const arma::vec&, const arma::vec&, const arma::uvec&, const blearner_factory_map&);
+    
+    void saveOptimizerState (std::ostream&) const;
+    void loadOptimizerState (std::istream&);
+};
+
+
+// Lazy coordinate descent:
+// -----------------------
+
+// The reduction of the SSE of a linear smoother is a squared semi norm of the
+// pseudo residuals which is bounded by the norm of the residuals. Hence, the
+// reduction of a factory can be bounded by the reduction of its last 
+// evaluation and the change of the residuals since then. Factories whose bound
+// can't beat the best evaluated factory are skipped, which still yields the
+// exact argmin:
+
+class OptimizerLazyCoordinateDescent : public Optimizer
+{
+  private:
+    
+    // Cumulated change of the pseudo residuals (triangle inequality) and the 
+    // pseudo residuals of the last iteration:
+    double residual_path = 0;
+    arma::vec last_pseudo_residuals;
+    
+    // Reduction of the SSE and residual path of the last evaluation:
+    std::map<std::string, double> last_reduction;
+    std::map<std::string, double> last_residual_path;
+    
+    // Number of evaluated and skipped factories per iteration:
+    std::vector<unsigned int> n_evaluated;
+    std::vector<unsigned int> n_pruned;
+    
+  public:
+    
+    OptimizerLazyCoordinateDescent ();
+    
+    blearner::Baselearner* findBestBaselearner (const std::string&, 
+      const arma::vec&, const arma::vec&, const arma::uvec&, const blearner_factory_map&);
+    
+    std::vector<unsigned int> getNumberOfEvaluatedFactories () const;
+    std::vector<unsigned int> getNumberOfPrunedFactories () const;
+};
+
+// Working set coordinate descent:
+// -----------------------
+
+// Approximate selection which just evaluates the best `n_working_set` 
+// factories of the last full sweep. A full sweep over all factories is done
+// every `refresh_iterations` iterations:
+
+class OptimizerWorkingSetCoordinateDescent : public Optimizer
+{
+  private:
+    
+    const unsigned int n_working_set;
+    const unsigned int refresh_iterations;
+    
+    unsigned int iterations_since_refresh = 0;
+    std::vector<std::string> working_set;
+    
+    // Flag for every iteration if the base-learner was selected by a full 
+    // sweep or from the working set:
+    std::vector<bool> full_sweeps;
+    
+  public:
+    
+    OptimizerWorkingSetCoordinateDescent (const unsigned int&, const unsigned int&);
+    
+    blearner::Baselearner* findBestBaselearner (const std::string&, 
+      const arma::vec&, const arma::vec&, const arma::uvec&, const blearner_factory_map&);
+    
+    void saveOptimizerState (std::ostream&) const;
+    void loadOptimizerState (std::istream&);
+    
+    std::vector<bool> getFullSweeps () const;
 };
 
+// Cached coordinate descent:
+// -----------------------
+
+// For the quadratic loss, the pseudo residuals change by the learning rate 
+// times the prediction of the selected base-learner. Hence, X_j^T r of every
+// factory changes by -nu X_j^T X_s beta_s. The cross products are kept and 
+// updated by the cross Gram matrices X_j^T X_s of the selected factory s 
+// which are computed once and cached for the `n_cached` most recently 
+// selected factories. The statistics are computed from scratch if they don't
+// match the pseudo residuals (e.g. for other losses or with momentum):
+
+class OptimizerCachedCoordinateDescent : public Optimizer
+{
+  private:
+    
+    const unsigned int n_cached;
+    
+    // Just the pseudo residuals of the quadratic loss change by the selected
+    // base-learner alone:
+    bool loss_is_quadratic = true;
+    
+    // X_j^T r and X_j^T X_j of every factory and the number of rows, the
+    // version, and the iteration of the prediction the cross products belong
+    // to:
+    std::map<std::string, arma::vec> crossprods;
+    std::map<std::string, arma::mat> grams;
+    bool statistics_are_valid = false;
+    double statistics_n_obs = 0;
+    unsigned int statistics_version = 0;
+    unsigned int statistics_iteration = 0;
+    
+    // Selected factory of the last iteration and its shrunken parameter 
+    // (empty if the pseudo residuals didn't change by this factory alone):
+    std::string selected_factory;
+    arma::vec selected_update;
+    
+    // Cross Gram matrices X_j^T X_s of the selected factories s and the 
+    // iteration of their last use:
+    std::map<std::string, std::map<std::string, arma::mat>> cross_grams;
+    std::map<std::string, unsigned int> last_use;
+    unsigned int iteration = 0;
+    
+    // Flag for every iteration if the statistics were computed from scratch:
+    std::vector<bool> full_sweeps;
+    
+    void computeStatistics (const arma::vec&, const blearner_factory_map&);
+    void computeCrossGrams (const std::string&, const blearner_factory_map&);
+    
+  public:
+    
+    OptimizerCachedCoordinateDescent (const unsigned int&);
+    
+    blearner::Baselearner* findBestBaselearner (const std::string&, 
+      const arma::vec&, const arma::vec&, const arma::uvec&, const blearner_factory_map&);
+    
+    void updateStatistics (loss::Loss*, blearner::Baselearner*, const double&, const double&);
+    void setPredictionVersion (const unsigned int&, const unsigned int&);
+    
+    std::vector<bool> getFullSweeps () const;
+    unsigned int getNumberOfCachedFactories () const;
+};
 
 } // namespace optimizer
 
@@ -0,0 +1,273 @@
+// ========================================================================== //
+//                                 ___.                          __           //
+//        ____  ____   _____ ______\_ |__   ____   ____  _______/  |_         //
+//      _/ ___\/  _ \ /     \\____ \| __ \ /  _ \ /  _ \/  ___/\   __\        //
+//      \  \__(  <_> )  Y Y  \  |_> > \_\ (  <_> |  <_> )___ \  |  |          //
+//       \___  >____/|__|_|  /   __/|___  /\____/ \____/____  > |__|          //
+//           \/            \/|__|       \/                  \/                //
+//                                                                            //
+// ========================================================================== //
+//
+// Compboost is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License.
+// Compboost is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// MIT License for more details. You should have received a copy of 
+// the MIT License along with compboost. 
+//
+// Written by:
+// -----------
+//
+//   Daniel Schalk
+//   Department of Statistics
+//   Ludwig-Maximilians-University Munich
+//   Ludwigstrasse 33
+//   D-80539 München
+//
+//   https://www.compstat.statistik.uni-muenchen.de
+//
+//   Contact
+//   e: contact@danielschalk.com
+//   w: danielschalk.com
+//
+// =========================================================================== #
+
+#include "piecewise_polynomial.h"
+
+namespace pwpolynomial
+{
+
+// -------------------------------------------------------------------------- //
+// PiecewisePolynomial:
+// -------------------------------------------------------------------------- //
+
+PiecewisePolynomial::PiecewisePolynomial () {}
+
+/**
+ * \brief Constructor with breakpoints and local coefficients
+ * 
+ * \param breakpoints `arma::vec` Sorted left breakpoints of the pieces.
+ * \param coefficients `arma::mat` Matrix with one column per piece containing
+ *   the coefficients of \f$u^0, \dots, u^p\f$ where \f$u = x - b_j\f$.
+ */
+PiecewisePolynomial::PiecewisePolynomial (const arma::vec& breakpoints, 
+  const arma::mat& coefficients)
+  : breakpoints ( breakpoints ),
+    coefficients ( coefficients )
+{
+  if (breakpoints.n_elem != coefficients.n_cols) {
+    throw std::runtime_error("Number of breakpoints must be equal to the number of pieces.");
+  }
+}
+
+/**
+ * \brief Index of the piece which contains the given point
+ * 
+ * Returns the largest index \f$j\f$ with \f$b_j \leq x\f$. Values smaller 
+ * than the first breakpoint are assigned to the first piece.
+ * 
+ * \param x `double` Point to search for.
+ * 
+ * \returns `unsigned int` index of the piece.
+ */
+unsigned int PiecewisePolynomial::findPiece (const double& x) const
+{
+  unsigned int idx = std::upper_bound(breakpoints.begin(), breakpoints.end(), x) - breakpoints.begin();
+  if (idx == 0) { return 0; }
+  
+  return idx - 1;
+}
+
+double PiecewisePolynomial::evaluate (const double& x) const
+{
+  unsigned int idx = findPiece(x);
+  double u = x - breakpoints[idx];
+  
+  // Horner scheme:
+  double out = 0;
+  for (int k = coefficients.n_rows - 1; k >= 0; k--) {
+    out = out * u + coefficients(k, idx);
+  }
+  return out;
+}
+
+arma::vec PiecewisePolynomial::evaluate (const arma::mat& values) const
+{
+  arma::vec out(values.n_elem, arma::fill::zeros);
+  if (isEmpty()) { return out; }
+  
+  for (unsigned int i = 0; i < values.n_elem; i++) {
+    out[i] = evaluate(values[i]);
+  }
+  return out;
+}
+
+/**
+ * \brief Add another piecewise polynomial
+ * 
+ * The new breakpoints are the union of both breakpoints. The polynomials of
+ * both summands are shifted to the new left breakpoints and then added up.
+ * The result is again exact since the sum of two polynomials is a 
+ * polynomial.
+ * 
+ * \param other `PiecewisePolynomial` Summand.
+ */
+void PiecewisePolynomial::add (const PiecewisePolynomial& other)
+{
+  if (other.isEmpty()) { return; }
+  if (isEmpty()) { 
+    breakpoints  = other.breakpoints;
+    coefficients = other.coefficients;
+    return; 
+  }
+  
+  arma::vec merged_breakpoints = arma::unique(arma::join_cols(breakpoints, other.breakpoints));
+  unsigned int n_coef = std::max(coefficients.n_rows, other.coefficients.n_rows);
+  
+  arma::mat merged_coefficients(n_coef, merged_breakpoints.n_elem, arma::fill::zeros);
+  
+  for (unsigned int j = 0; j < merged_breakpoints.n_elem; j++) {
+    
+    double b = merged_breakpoints[j];
+    
+    unsigned int idx = findPiece(b);
+    arma::vec shifted = shiftPolynomial(coefficients.col(idx), b - breakpoints[idx]);
+    merged_coefficients(arma::span(0, shifted.n_elem - 1), j) += shifted;
+    
+    idx = other.findPiece(b);
+    shifted = shiftPolynomial(other.coefficients.col(idx), b - other.breakpoints[idx]);
+    merged_coefficients(arma::span(0, shifted.n_elem - 1), j) += shifted;
+  }
+  breakpoints  = merged_breakpoints;
+  coefficients = merged_coefficients;
+}
+
+bool PiecewisePolynomial::isEmpty () const
+{
+  return breakpoints.n_elem == 0;
+}
+
+arma::vec PiecewisePolynomial::getBreakpoints () const
+{
+  return breakpoints;
+}
+
+arma::mat PiecewisePolynomial::getCoefficients () const
+{
+  return coefficients;
+}
+
+// -------------------------------------------------------------------------- //
+// Helper:
+// -------------------------------------------------------------------------- //
+
+/**
+ * \brief Shift polynomial coefficients 
+ * 
+ * Computes the coefficients of \f$q(u) = p(u + \delta)\f$ by repeated 
+ * synthetic division (Taylor shift), which requires \f$O(p^2)\f$ operations.
+ * 
+ * \param coefficients `arma::vec` Coefficients of \f$p\f$ in increasing order.
+ * \param delta `double` Shift of the origin.
+ * 
+ * \returns `arma::vec` Coefficients of \f$q\f$ in increasing order.
+ */
+arma::vec shiftPolynomial (const arma::vec& coefficients, const double& delta)
+{
+  arma::vec out = coefficients;
+  if (delta == 0) { return out; }
+  
+  int n = out.n_elem;
+  for (int i = 0; i < n - 1; i++) {
+    for (int j = n - 2; j >= i; j--) {
+      out[j] += delta * out[j + 1];
+    }
+  }
+  return out;
+}
+
+/**
+ * \brief Convert a spline into a piecewise polynomial
+ * 
+ * For each knot interval \f$[t_i, t_{i+1})\f$ which contains data 
+ * (\f$i = p, \dots, n_\mathrm{basis} - 1\f$) the spline is evaluated at 
+ * \f$p + 1\f$ Chebyshev points of the interval. The interpolating polynomial
+ * of degree \f$p\f$ is then exactly the spline on this interval. To keep the
+ * Vandermonde system well conditioned it is set up on the rescaled interval
+ * \f$[0,1]\f$ and the coefficients are scaled back afterwards. Since the
+ * system is the same for all intervals just one solve with multiple right
+ * hand sides is required.
+ * 
+ * \param parameter `arma::vec` Estimated spline parameter.
+ * \param degree `unsigned int` Polynomial degree of the splines.
+ * \param knots `arma::vec` Knots used to create the basis.
+ * 
+ * \returns `PiecewisePolynomial` representing the spline.
+ */
+PiecewisePolynomial splineToPiecewisePolynomial (const arma::vec& parameter, 
+  const unsigned int& degree, const arma::vec& knots)
+{
+  unsigned int n_basis  = knots.size() - (degree + 1);
+  unsigned int n_pieces = n_basis - degree;
+  
+  if (parameter.n_elem != n_basis) {
+    throw std::runtime_error("Number of parameter does not match the number of spline bases.");
+  }
+  
+  // Chebyshev points and Vandermonde matrix on [0,1]:
+  arma::vec cheb_points(degree + 1);
+  arma::mat vandermonde(degree + 1, degree + 1);
+  for (unsigned int i = 0; i <= degree; i++) {
+    cheb_points[i] = 0.5 - 0.5 * std::cos((2.0 * i + 1.0) * arma::datum::pi / (2.0 * (degree + 1)));
+    for (unsigned int k = 0; k <= degree; k++) {
+      vandermonde(i, k) = std::pow(cheb_points[i], k);
+    }
+  }
+  
+  arma::vec breakpoints(n_pieces);
+  arma::mat values(degree + 1, n_pieces);
+  
+  for (unsigned int j = 0; j < n_pieces; j++) {
+    unsigned int idx = degree + j;
+    double h = knots[idx + 1] - knots[idx];
+    
+    breakpoints[j] = knots[idx];
+    for (unsigned int i = 0; i <= degree; i++) {
+      arma::rowvec basis = deBoorBasis(knots[idx] + cheb_points[i] * h, idx, degree, knots);
+      values(i, j) = arma::dot(basis, parameter.subvec(idx - degree, idx));
+    }
+  }
+  arma::mat coefficients = arma::solve(vandermonde, values);
+  
+  // Transform back from [0,1] to local coordinates u = x - t_i:
+  for (unsigned int j = 0; j < n_pieces; j++) {
+    double h = knots[degree + j + 1] - knots[degree + j];
+    double scale = 1;
+    for (unsigned int k = 0; k <= degree; k++) {
+      coefficients(k, j) /= scale;
+      scale *= h;
+    }
+  }
+  return PiecewisePolynomial(breakpoints, coefficients);
+}
+
+/**
+ * \brief Convert a global polynomial into a piecewise polynomial
+ * 
+ * The result has just one piece with breakpoint zero, hence the local
+ * coefficients are the global ones.
+ * 
+ * \param coefficients `arma::vec` Coefficients of \f$x^0, \dots, x^p\f$.
+ * 
+ * \returns `PiecewisePolynomial` with one piece.
+ */
+PiecewisePolynomial polynomialToPiecewisePolynomial (const arma::vec& coefficients)
+{
+  arma::vec breakpoints(1, arma::fill::zeros);
+  arma::mat coef_mat = coefficients;
+  
+  return PiecewisePolynomial(breakpoints, coef_mat);
+}
+
+} // namespace pwpolynomial
@@ -0,0 +1,147 @@
+// ========================================================================== //
+//                                 ___.                          __           //
+//        ____  ____   _____ ______\_ |__   ____   ____  _______/  |_         //
+//      _/ ___\/  _ \ /     \\____ \| __ \ /  _ \ /  _ \/  ___/\   __\        //
+//      \  \__(  <_> )  Y Y  \  |_> > \_\ (  <_> |  <_> )___ \  |  |          //
+//       \___  >____/|__|_|  /   __/|___  /\____/ \____/____  > |__|          //
+//           \/            \/|__|       \/                  \/                //
+//                                                                            //
+// ========================================================================== //
+//
+// Compboost is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License.
+// Compboost is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// MIT License for more details. You should have received a copy of 
+// the MIT License along with compboost. 
+//
+// Written by:
+// -----------
+//
+//   Daniel Schalk
+//   Department of Statistics
+//   Ludwig-Maximilians-University Munich
+//   Ludwigstrasse 33
+//   D-80539 München
+//
+//   https://www.compstat.statistik.uni-muenchen.de
+//
+//   Contact
+//   e: contact@danielschalk.com
+//   w: danielschalk.com
+//
+// =========================================================================== #
+
+/** 
+ *  @file    piecewise_polynomial.h
+ *  @author  Daniel Schalk (github: schalkdaniel)
+ *  
+ *  @brief Piecewise polynomial representation of univariate effects
+ *
+ *  @section DESCRIPTION
+ *  
+ *  A fitted univariate P-spline or polynomial base-learner is a fixed 
+ *  function of one raw feature. Instead of creating the basis of every new
+ *  observation (de Boor + matrix product) we convert the estimated parameter
+ *  once into a piecewise polynomial. That is, for every knot interval we store
+ *  the coefficients of the polynomial which is exactly the spline on that 
+ *  interval. Evaluating a new point then just requires one binary search for
+ *  the interval and a Horner scheme of length `degree + 1`.
+ *  
+ *  The conversion is exact in exact arithmetic since a spline of degree 
+ *  \f$p\f$ is a polynomial of degree \f$p\f$ on each knot interval. In 
+ *  floating point arithmetic the coefficients are obtained by solving a 
+ *  \f$(p+1)\times(p+1)\f$ Vandermonde system on Chebyshev points of the
+ *  rescaled interval \f$[0,1]\f$. For the usual degrees \f$p \leq 5\f$ the
+ *  condition number of that system is below 500, hence the relative error
+ *  of the evaluation is of order \f$10^{-13}\f$ compared to the basis
+ *  representation.
+ *
+ */
+
+#ifndef PIECEWISE_POLYNOMIAL_H_
+#define PIECEWISE_POLYNOMIAL_H_
+
+#include <RcppArmadillo.h>
+
+#include <algorithm> // ::upper_bound
+#include <cmath>
+#include <stdexcept> // ::runtime_error
+
+#include "splines.h"
+
+namespace pwpolynomial
+{
+
+/**
+ * \class PiecewisePolynomial
+ * 
+ * \brief Piecewise polynomial of one feature
+ * 
+ * The polynomial of piece \f$j\f$ is stored in local coordinates 
+ * \f$u = x - b_j\f$ where \f$b_j\f$ is the left breakpoint of the piece. 
+ * Local coordinates keeps the coefficients well conditioned. The first piece
+ * is extended to \f$-\infty\f$ and the last one to \f$\infty\f$. Hence, 
+ * values outside of the knot range are extrapolated by the polynomial of the
+ * boundary interval, which is exactly what de Boor's algorithm does for 
+ * values close to the boundary.
+ * 
+ * Piecewise polynomials can be added up. This is used to collapse all 
+ * univariate effects of one feature into one evaluator.
+ * 
+ */
+
+class PiecewisePolynomial
+{
+private:
+  
+  /// Left breakpoints of the pieces (sorted)
+  arma::vec breakpoints;
+  
+  /// Coefficients, column \f$j\f$ contains the coefficients of piece \f$j\f$ in increasing order
+  arma::mat coefficients;
+  
+public:
+  
+  /// Empty piecewise polynomial (evaluates to zero)
+  PiecewisePolynomial ();
+  
+  /// Constructor with breakpoints and local coefficients
+  PiecewisePolynomial (const arma::vec&, const arma::mat&);
+  
+  /// Index of the piece which contains the given point
+  unsigned int findPiece (const double&) const;
+  
+  /// Evaluate at a single point
+  double evaluate (const double&) const;
+  
+  /// Evaluate at a vector of points (or a matrix with one column)
+  arma::vec evaluate (const arma::mat&) const;
+  
+  /// Add another piecewise polynomial (breakpoints are merged)
+  void add (const PiecewisePolynomial&);
+  
+  /// Check if there are no pieces at all
+  bool isEmpty () const;
+  
+  /// Getter for the breakpoints
+  arma::vec getBreakpoints () const;
+  
+  /// Getter for the coefficient matrix
+  arma::mat getCoefficients () const;
+};
+
+/// Shift polynomial coefficients from origin \f$a\f$ to origin \f$a + \delta\f$
+arma::vec shiftPolynomial (const arma::vec&, const double&);
+
+/// Convert a spline with given parameter, degree, and knots into a piecewise polynomial
+PiecewisePolynomial splineToPiecewisePolynomial (const arma::vec&, const unsigned int&, 
+  const arma::vec&);
+
+/// Convert a global polynomial (increasing order) into a piecewise polynomial
+PiecewisePolynomial polynomialToPiecewisePolynomial (const arma::vec&);
+
+} // namespace pwpolynomial
+
+#endif // PIECEWISE_POLYNOMIAL_H_
@@ -0,0 +1,233 @@
+// ========================================================================== //
+//                                 ___.                          __           //
+//        ____  ____   _____ ______\_ |__   ____   ____  _______/  |_         //
+//      _/ ___\/  _ \ /     \\____ \| __ \ /  _ \ /  _ \/  ___/\   __\        //
+//      \  \__(  <_> )  Y Y  \  |_> > \_\ (  <_> |  <_> )___ \  |  |          //
+//       \___  >____/|__|_|  /   __/|___  /\____/ \____/____  > |__|          //
+//           \/            \/|__|       \/                  \/                //
+//                                                                            //
+// ========================================================================== //
+//
+// Compboost is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License.
+// Compboost is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// MIT License for more details. You should have received a copy of 
+// the MIT License along with compboost. 
+//
+// Written by:
+// -----------
+//
+//   Daniel Schalk
+//   Department of Statistics
+//   Ludwig-Maximilians-University Munich
+//   Ludwigstrasse 33
+//   D-80539 München
+//
+//   https://www.compstat.statistik.uni-muenchen.de
+//
+//   Contact
+//   e: contact@danielschalk.com
+//   w: danielschalk.com
+//
+// =========================================================================== #
+
+
+#include "serialize.h"
+
+namespace serialize
+{
+
+/**
+ * \brief Write the magic string and version at the beginning of a file
+ * 
+ * \param out `std::ostream` stream to write to
+ * \param magic `std::string` string which identifies the content
+ * \param version `uint32_t` version of the format
+ */
+void writeHeader (std::ostream& out, const std::string& magic, const uint32_t& version)
+{
+  out.write(magic.data(), magic.size());
+  out.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+}
+
+/**
+ * \brief Check the magic string and return the version of the file
+ * 
+ * \param in `std::istream` stream to read from
+ * \param magic `std::string` expected string at the beginning of the file
+ * 
+ * \returns `uint32_t` version of the format
+ */
+uint32_t readHeader (std::istream& in, const std::string& magic)
+{
+  std::string file_magic (magic.size(), ' ');
+  in.read(&file_magic[0], magic.size());
+  if (! in || file_magic != magic) {
+    Rcpp::stop("The file was not written by compboost or contains another object.");
+  }
+  uint32_t version;
+  in.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+  return version;
+}
+
+void writeUInt (std::ostream& out, const uint64_t& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(uint64_t));
+}
+
+uint64_t readUInt (std::istream& in)
+{
+  uint64_t value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(uint64_t));
+  if (! in) {
+    Rcpp::stop("Unexpected end of file.");
+  }
+  return value;
+}
+
+void writeDouble (std::ostream& out, const double& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(double));
+}
+
+double readDouble (std::istream& in)
+{
+  double value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(double));
+  if (! in) {
+    Rcpp::stop("Unexpected end of file.");
+  }
+  return value;
+}
+
+void writeString (std::ostream& out, const std::string& value)
+{
+  writeUInt(out, value.size());
+  out.write(value.data(), value.size());
+}
+
+std::string readString (std::istream& in)
+{
+  uint64_t size = readUInt(in);
+  std::string value (size, ' ');
+  if (size > 0) {
+    in.read(&value[0], size);
+  }
+  if (! in) {
+    Rcpp::stop("Unexpected end of file.");
+  }
+  return value;
+}
+
+/**
+ * \brief Write matrix as dimension followed by the column wise values
+ * 
+ * \param out `std::ostream` stream to write to
+ * \param mat `arma::mat` matrix to write
+ */
+void writeMat (std::ostream& out, const arma::mat& mat)
+{
+  writeUInt(out, mat.n_rows);
+  writeUInt(out, mat.n_cols);
+  out.write(reinterpret_cast<const char*>(mat.memptr()), mat.n_elem * sizeof(double));
+}
+
+arma::mat readMat (std::istream& in)
+{
+  uint64_t n_rows = readUInt(in);
+  uint64_t n_cols = readUInt(in);
+  
+  arma::mat mat (n_rows, n_cols);
+  in.read(reinterpret_cast<char*>(mat.memptr()), mat.n_elem * sizeof(double));
+  if (! in) {
+    Rcpp::stop("Unexpected end of file.");
+  }
+  return mat;
+}
+
+/**
+ * \brief Write sparse matrix in compressed sparse column format
+ * 
+ * \param out `std::ostream` stream to write to
+ * \param mat `arma::sp_mat` sparse matrix to write
+ */
+void writeSpMat (std::ostream& out, const arma::sp_mat& mat)
+{
+  mat.sync();
+  writeUInt(out, mat.n_rows);
+  writeUInt(out, mat.n_cols);
+  writeUInt(out, mat.n_nonzero);
+  
+  out.write(reinterpret_cast<const char*>(mat.values), mat.n_nonzero * sizeof(double));
+  for (unsigned int i = 0; i < mat.n_nonzero; i++) {
+    writeUInt(out, mat.row_indices[i]);
+  }
+  for (unsigned int i = 0; i < mat.n_cols + 1; i++) {
+    writeUInt(out, mat.col_ptrs[i]);
+  }
+}
+
+arma::sp_mat readSpMat (std::istream& in)
+{
+  uint64_t n_rows = readUInt(in);
+  uint64_t n_cols = readUInt(in);
+  uint64_t n_nonzero = readUInt(in);
+  
+  arma::vec values (n_nonzero);
+  in.read(reinterpret_cast<char*>(values.memptr()), n_nonzero * sizeof(double));
+  
+  arma::uvec row_indices (n_nonzero);
+  for (unsigned int i = 0; i < n_nonzero; i++) {
+    row_indices(i) = readUInt(in);
+  }
+  arma::uvec col_ptrs (n_cols + 1);
+  for (unsigned int i = 0; i < n_cols + 1; i++) {
+    col_ptrs(i) = readUInt(in);
+  }
+  return arma::sp_mat(row_indices, col_ptrs, values, n_rows, n_cols);
+}
+
+void openOutputFile (std::ofstream& out, const std::string& file_name)
+{
+  out.open(file_name.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (! out.is_open()) {
+    Rcpp::stop("Could not open file '" + file_name + "' for writing.");
+  }
+}
+
+void openInputFile (std::ifstream& in, const std::string& file_name)
+{
+  in.open(file_name.c_str(), std::ios::in | std::ios::binary);
+  if (! in.is_open()) {
+    Rcpp::stop("Could not open file '" + file_name + "' for reading.");
+  }
+}
+
+/**
+ * \brief Hash of the dimension and the values of a matrix
+ * 
+ * This is the 64 bit FNV-1a hash of the raw bytes. It is used to recognize
+ * if prepared data was created from the same raw data.
+ * 
+ * \param mat `arma::mat` matrix to hash
+ * 
+ * \returns `std::string` of the dimension and hex encoded hash
+ */
+std::string fingerprint (const arma::mat& mat)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(mat.memptr());
+  
+  for (std::size_t i = 0; i < mat.n_elem * sizeof(double); i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  std::stringstream ss;
+  ss << mat.n_rows << "x" << mat.n_cols << ":" << std::hex << hash;
+  
+  return ss.str();
+}
+
+} // namespace serialize
@@ -0,0 +1,100 @@
+// ========================================================================== //
+//                                 ___.                          __           //
+//        ____  ____   _____ ______\_ |__   ____   ____  _______/  |_         //
+//      _/ ___\/  _ \ /     \\____ \| __ \ /  _ \ /  _ \/  ___/\   __\        //
+//      \  \__(  <_> )  Y Y  \  |_> > \_\ (  <_> |  <_> )___ \  |  |          //
+//       \___  >____/|__|_|  /   __/|___  /\____/ \____/____  > |__|          //
+//           \/            \/|__|       \/                  \/                //
+//                                                                            //
+// ========================================================================== //
+//
+// Compboost is free software: you can redistribute it and/or modify
+// it under the terms of the MIT License.
+// Compboost is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// MIT License for more details. You should have received a copy of 
+// the MIT License along with compboost. 
+//
+// Written by:
+// -----------
+//
+//   Daniel Schalk
+//   Department of Statistics
+//   Ludwig-Maximilians-University Munich
+//   Ludwigstrasse 33
+//   D-80539 München
+//
+//   https://www.compstat.statistik.uni-muenchen.de
+//
+//   Contact
+//   e: contact@danielschalk.com
+//   w: danielschalk.com
+//
+// =========================================================================== #
+
+
+/** 
+ *  @file    serialize.h
+ *  @author  Daniel Schalk (github: schalkdaniel)
+ *  
+ *  @brief Helper to write and read binary files
+ *
+ *  @section DESCRIPTION
+ *  
+ *  Prepared data objects and trained models can be stored in binary files to
+ *  avoid the recomputation of e.g. the spline basis after restarting a 
+ *  session. Every file starts with a magic string which identifies the 
+ *  content and a format version. Matrices are stored column wise as raw 
+ *  doubles (the native memory layout of Armadillo), hence reading a matrix
+ *  is just one read call into the memory of the new matrix.
+ *  
+ *  The files are meant to be read on the same architecture they are written
+ *  (no conversion of the byte order is done).
+ *
+ */
+
+#ifndef SERIALIZE_H_
+#define SERIALIZE_H_
+
+#include <RcppArmadillo.h>
+
+#include <fstream>
+#include <string>
+#include <cstdint>
+#include <sstream>
+
+namespace serialize
+{
+
+/// Write the magic string and version at the beginning of a file
+void writeHeader (std::ostream&, const std::string&, const uint32_t&);
+
+/// Check the magic string and return the version of the file
+uint32_t readHeader (std::istream&, const std::string&);
+
+void writeUInt (std::ostream&, const uint64_t&);
+uint64_t readUInt (std::istream&);
+
+void writeDouble (std::ostream&, const double&);
+double readDouble (std::istream&);
+
+void writeString (std::ostream&, const std::string&);
+std::string readString (std::istream&);
+
+void writeMat (std::ostream&, const arma::mat&);
+arma::mat readMat (std::istream&);
+
+void writeSpMat (std::ostream&, const arma::sp_mat&);
+arma::sp_mat readSpMat (std::istream&);
+
+/// Open file for writing or reading and throw an error if that fails
+void openOutputFile (std::ofstream&, const std::string&);
+void openInputFile (std::ifstream&, const std::string&);
+
+/// Hash of the dimension and the values of a matrix to recognize data
+std::string fingerprint (const arma::mat&);
+
+} // namespace serialize
+
+#endif // SERIALIZE_H_
@@ -148,6 +148,52 @@ arma::vec createKnots (const arma::vec& values, const unsigned int& n_knots,
   return knots;
 }
 
+/**
+ * \brief Non-zero basis functions of a point within a given span
+ * 
+ * De Boors algorithm to compute the `degree + 1` basis functions which are
+ * non-zero on the knot interval `[knots[idx], knots[idx + 1])`. The span is
+ * not checked against `x`, hence, for `x` outside of the span this returns 
+ * the basis of the polynomial pieces which belong to that span.
+ * 
+ * \param x `double` Point to evaluate the basis.
+ * \param idx `unsigned int` Index of the span (see `findSpan`).
+ * \param degree `unsigned int` polynomial degree of splines.
+ * \param knots `arma::vec` Vector of knots.
+ * 
+ * \returns `arma::rowvec` of the `degree + 1` non-zero basis functions.
+ */
+
+arma::rowvec deBoorBasis (const double& x, const unsigned int& idx, 
+  const unsigned int& degree, const arma::vec& knots)
+{
+  arma::rowvec N(degree + 1, arma::fill::zeros);
+  N[0] = 1.0;
+
+  arma::vec left(degree + 1, arma::fill::zeros);
+  arma::vec right(degree + 1, arma::fill::zeros);
+
+  double saved;
+  double temp;
+
+  // De Boors algorithm to recursive find base in a triangle scheme:
+  for (unsigned int j = 1; j <= degree; j++) {
+
+    left[j]  = x - knots[idx + 1 - j];
+    right[j] = knots[idx + j] - x;
+
+    saved = 0;
+
+    for (unsigned int r = 0; r < j; r++) {
+      temp  = N[r] / (right[r + 1] + left[j - r]);
+      N[r]  = saved + right[r + 1] * temp;
+      saved = left[j - r] * temp;
+    }
+    N[j] = saved;
+  }
+  return N;
+}
+
 /**
  * \brief Transformation from a vector of input points to matrix of basis
  * 
@@ -188,30 +234,7 @@ arma::mat createSplineBasis (const arma::vec& values, const unsigned int& degree
     if (idx > (n_cols - 1)) { idx = n_cols - 1; }
 
     // Output for basis functions. Here we have the non-zero entries:
-    arma::rowvec N(degree + 1, arma::fill::zeros);
-    N[0] = 1.0;
-
-    arma::vec left(degree + 1, arma::fill::zeros);
-    arma::vec right(degree + 1, arma::fill::zeros);
-
-    double saved;
-    double temp;
-
-    // De Boors algorithm to recursive find base in a triangle scheme:
-    for (unsigned int j = 1; j <= degree; j++) {
-
-      left[j]  = x - knots[idx + 1 - j];
-      right[j] = knots[idx + j] - x;
-
-      saved = 0;
-
-      for (unsigned int r = 0; r < j; r++) {
-        temp  = N[r] / (right[r + 1] + left[j - r]);
-        N[r]  = saved + right[r + 1] * temp;
-        saved = left[j - r] * temp;
-      }
-      N[j] = saved;
-    }
+    arma::rowvec N = deBoorBasis(x, idx, degree, knots);
     spline_basis(actual_row, arma::span(idx - degree, idx)) = N;
   }
   return spline_basis;
@@ -261,30 +284,7 @@ arma::sp_mat createSparseSplineBasis (const arma::vec& values, const unsigned in
     if (idx > (full_base.n_cols - 1)) { idx = full_base.n_cols - 1; }
 
     // Output for basis functions. Here we have the non-zero entries:
-    arma::rowvec N(degree + 1, arma::fill::zeros);
-    N[0] = 1.0;
-
-    arma::vec left(degree + 1, arma::fill::zeros);
-    arma::vec right(degree + 1, arma::fill::zeros);
-
-    double saved;
-    double temp;
-
-    // De Boors algorithm to recursive find base in a triangle scheme:
-    for (unsigned int j = 1; j <= degree; j++) {
-
-      left[j]  = x - knots[idx + 1 - j];
-      right[j] = knots[idx + j] - x;
-
-      saved = 0;
-
-      for (unsigned int r = 0; r < j; r++) {
-        temp  = N[r] / (right[r + 1] + left[j - r]);
-        N[r]  = saved + right[r + 1] * temp;
-        saved = left[j - r] * temp;
-      }
-      N[j] = saved;
-    }
+    arma::rowvec N = deBoorBasis(x, idx, degree, knots);
     // Fill variables needed to define the sparse matrix:
     for (unsigned int i = 0; i < N.size(); i++) {
 
@@ -300,3 +300,84 @@ arma::sp_mat createSparseSplineBasis (const arma::vec& values, const unsigned in
   
   return out;
 }
+
+/**
+ * \brief Demmler-Reinsch orthogonalization of the penalized cross product
+ * 
+ * With the Cholesky decomposition \f$X^T X = L L^T\f$ and the eigen 
+ * decomposition \f$L^{-1} K L^{-T} = U \mathrm{diag}(s) U^T\f$ the matrix
+ * \f$A = L^{-T} U\f$ diagonalizes both matrices, \f$A^T X^T X A = I\f$ and
+ * \f$A^T K A = \mathrm{diag}(s)\f$. Hence, for every penalty \f$\lambda\f$
+ * \f[
+ *   (X^T X + \lambda K)^{-1} = A \mathrm{diag}(1 / (1 + \lambda s)) A^T
+ * \f]
+ * and the degrees of freedom are \f$\sum_i 1 / (1 + \lambda s_i)\f$. The
+ * cross product is singular if a basis function has no observations, then a
+ * small ridge is added. No `R` API is used, hence the function can be called
+ * from other threads.
+ * 
+ * \param XtX `arma::mat` Cross product of the basis.
+ * \param penalty_mat `arma::mat` Penalty matrix.
+ * \param dr_basis `arma::mat` Matrix \f$A\f$ which is set by the function.
+ * \param dr_eigenvalues `arma::vec` Eigenvalues \f$s\f$ which are set by 
+ *   the function.
+ * 
+ * \returns `bool` Flag if the decomposition was successful.
+ */
+
+bool demmlerReinsch (const arma::mat& XtX, const arma::mat& penalty_mat, arma::mat& dr_basis, 
+  arma::vec& dr_eigenvalues)
+{
+  arma::mat L;
+  if (! arma::chol(L, XtX, "lower")) {
+    arma::mat ridge = 1e-10 * arma::trace(XtX) / XtX.n_rows * arma::eye<arma::mat>(XtX.n_rows, XtX.n_cols);
+    if (! arma::chol(L, XtX + ridge, "lower")) { return false; }
+  }
+  arma::mat L_inv = arma::inv(arma::trimatl(L));
+  arma::mat U;
+  
+  if (! arma::eig_sym(dr_eigenvalues, U, arma::symmatu(L_inv * penalty_mat * L_inv.t()))) { 
+    return false; 
+  }
+  // The penalty is positive semi-definite, negative values are rounding errors:
+  dr_eigenvalues.elem(arma::find(dr_eigenvalues < 0)).zeros();
+  dr_basis = L_inv.t() * U;
+  
+  return true;
+}
+
+/**
+ * \brief Penalty which yields given degrees of freedom
+ * 
+ * The degrees of freedom \f$\mathrm{df}(\lambda) = \sum_i 1 / (1 + \lambda s_i)\f$
+ * decrease monotonically from the number of eigenvalues (\f$\lambda = 0\f$)
+ * to the number of zero eigenvalues (the null space of the penalty). The 
+ * penalty is found by bisection on \f$\log(\lambda)\f$ which just requires
+ * the eigenvalues of the Demmler-Reinsch orthogonalization. No `R` API is 
+ * used, hence the function can be called from other threads.
+ * 
+ * \param dr_eigenvalues `arma::vec` Eigenvalues \f$s\f$ of `demmlerReinsch()`.
+ * \param df `double` Degrees of freedom.
+ * 
+ * \returns `double` Penalty \f$\lambda\f$ with \f$\mathrm{df}(\lambda) = \mathrm{df}\f$.
+ */
+
+double demmlerReinschPenalty (const arma::vec& dr_eigenvalues, const double& df)
+{
+  if (df >= dr_eigenvalues.n_elem) { return 0; }
+  
+  double log_lower = -30;
+  double log_upper = 50;
+  
+  for (unsigned int i = 0; i < 100; i++) {
+    double log_penalty = (log_lower + log_upper) / 2;
+    double df_penalty  = arma::accu(1 / (1 + std::exp(log_penalty) * dr_eigenvalues));
+    
+    if (df_penalty > df) {
+      log_lower = log_penalty;
+    } else {
+      log_upper = log_penalty;
+    }
+  }
+  return std::exp((log_lower + log_upper) / 2);
+}
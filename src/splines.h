@@ -41,7 +41,10 @@
 arma::mat penaltyMat (const unsigned int&, const unsigned int&);
 unsigned int findSpan (const double&, const arma::vec&);
 arma::vec createKnots (const arma::vec&, const unsigned int&,const unsigned int&);
+arma::rowvec deBoorBasis (const double&, const unsigned int&, const unsigned int&, const arma::vec&);
 arma::mat createSplineBasis (const arma::vec&, const unsigned int&, const arma::vec&);
 arma::sp_mat createSparseSplineBasis (const arma::vec&, const unsigned int&, const arma::vec&);
+bool demmlerReinsch (const arma::mat&, const arma::mat&, arma::mat&, arma::vec&);
+double demmlerReinschPenalty (const arma::vec&, const double&);
 
 # endif // SPLINE_CPP_